@@ -8,7 +8,6 @@ struct Camera
 	XMVECTOR up = XMVectorSet(0, 1, 0, 0);
 	XMVECTOR front = XMVectorSet(0, 0, 10, 0);
 
-	XMMATRIX model;
 	XMMATRIX view;
 	XMMATRIX projection;
 
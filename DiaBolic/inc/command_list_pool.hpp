@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+
+// Command allocators and lists of a single thread, without any D3D12 in it.
+// Allocators are counted from creation until they are trimmed, the count never exceeds the cap.
+// Submitters hand allocators and lists back through a lock-free stack, possibly from another thread.
+// Lists that were recorded but never submitted are handed back the same way with fence value 0,
+// so their allocators are reusable right away and their slot under the cap isn't lost.
+//
+// Everything except Retire() belongs to the owning thread and has to be called with the mutex held.
+template<typename Allocator, typename CommandList>
+class CommandListPool
+{
+public:
+	CommandListPool(uint32_t maxAllocatorCount, std::chrono::steady_clock::duration idleTimeout)
+		: _maxAllocatorCount(maxAllocatorCount)
+		, _idleTimeout(idleTimeout)
+	{
+	}
+
+	~CommandListPool()
+	{
+		CollectRetired();
+	}
+
+	CommandListPool(const CommandListPool& other) = delete;
+	CommandListPool& operator=(const CommandListPool& other) = delete;
+
+	// Safe to call from any thread. The allocator is reused once the fence reached fenceValue.
+	void Retire(Allocator allocator, CommandList commandList, uint64_t fenceValue)
+	{
+		RetiredEntry* entry = new RetiredEntry{ { fenceValue, std::move(allocator) }, std::move(commandList) };
+
+		entry->next = _retiredEntries.load(std::memory_order_relaxed);
+		while (!_retiredEntries.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// Moves everything handed back through Retire() into the pool.
+	void CollectRetired()
+	{
+		RetiredEntry* entry = _retiredEntries.exchange(nullptr, std::memory_order_acquire);
+
+		// The stack hands entries back newest first, restore submission order.
+		RetiredEntry* reversed = nullptr;
+		while (entry)
+		{
+			RetiredEntry* next = entry->next;
+			entry->next = reversed;
+			reversed = entry;
+			entry = next;
+		}
+
+		while (reversed)
+		{
+			RetiredEntry* next = reversed->next;
+			_allocators.emplace_back(std::move(reversed->allocatorEntry));
+			_commandLists.emplace(std::move(reversed->commandList));
+			delete reversed;
+			reversed = next;
+		}
+	}
+
+	// Reuses a completed allocator, or returns nothing while the pool is below its cap. The caller then
+	// creates a new allocator, which is already counted. At the cap this blocks on the oldest allocator
+	// in flight through waitForFenceValue(fenceValue) instead of growing, the cap is never exceeded.
+	// Reused allocators still have to be reset by the caller.
+	template<typename WaitFunction>
+	[[nodiscard]] std::optional<Allocator> AcquireAllocator(uint64_t completedFenceValue, const WaitFunction& waitForFenceValue)
+	{
+		// Prefer the most recently retired allocator that is done. Surplus allocators from
+		// a spike then stay untouched at the front of the queue until they are trimmed.
+		auto reusable = std::find_if(_allocators.rbegin(), _allocators.rend(), [=](const AllocatorEntry& entry) {
+			return entry.fenceValue <= completedFenceValue;
+		});
+
+		if (reusable == _allocators.rend() && !_allocators.empty() && _allocatorCount >= _maxAllocatorCount)
+		{
+			auto oldest = std::min_element(_allocators.begin(), _allocators.end(), [](const AllocatorEntry& a, const AllocatorEntry& b) {
+				return a.fenceValue < b.fenceValue;
+			});
+			waitForFenceValue(oldest->fenceValue);
+			reusable = std::make_reverse_iterator(std::next(oldest));
+		}
+
+		if (reusable != _allocators.rend())
+		{
+			Allocator allocator = std::move(reusable->allocator);
+			_allocators.erase(std::next(reusable).base());
+			return allocator;
+		}
+
+		// Nothing to wait on, every allocator of this thread is still being recorded into.
+		// Waiting for another thread to submit one of them could deadlock, so this is an error.
+		if (_allocatorCount >= _maxAllocatorCount)
+		{
+			throw std::runtime_error("A single thread has MAX_COMMAND_ALLOCATORS_PER_THREAD command lists open.");
+		}
+
+		++_allocatorCount;
+		return std::nullopt;
+	}
+
+	// Returns a list to reset, or nothing if the caller has to create one.
+	[[nodiscard]] std::optional<CommandList> AcquireCommandList()
+	{
+		if (_commandLists.empty())
+		{
+			return std::nullopt;
+		}
+
+		CommandList commandList = std::move(_commandLists.front());
+		_commandLists.pop();
+		return commandList;
+	}
+
+	// Release allocators that completed and haven't been reused for the idle timeout,
+	// together with the command lists that are no longer needed next to them.
+	// Returns the number of allocators released.
+	uint32_t TrimIdle(uint64_t completedFenceValue, std::chrono::steady_clock::time_point now)
+	{
+		for (AllocatorEntry& entry : _allocators)
+		{
+			// The idle time counts from when the pool first saw the fence value complete.
+			if (entry.fenceValue <= completedFenceValue && entry.completionTime == std::chrono::steady_clock::time_point{})
+			{
+				entry.completionTime = now;
+			}
+		}
+
+		const size_t previousSize = _allocators.size();
+		std::erase_if(_allocators, [&](const AllocatorEntry& entry) {
+			return entry.fenceValue <= completedFenceValue && now - entry.completionTime > _idleTimeout;
+		});
+
+		const uint32_t releasedCount = static_cast<uint32_t>(previousSize - _allocators.size());
+		_allocatorCount -= releasedCount;
+
+		while (_commandLists.size() > _allocatorCount)
+		{
+			_commandLists.pop();
+		}
+
+		return releasedCount;
+	}
+
+	[[nodiscard]] std::mutex& GetMutex() { return _mutex; }
+
+	// Allocators owned by this pool, either in flight, recording or idle.
+	[[nodiscard]] uint32_t GetAllocatorCount() const { return _allocatorCount; }
+
+private:
+	struct AllocatorEntry
+	{
+		uint64_t fenceValue;
+		Allocator allocator;
+		std::chrono::steady_clock::time_point completionTime{};
+	};
+
+	struct RetiredEntry
+	{
+		AllocatorEntry allocatorEntry;
+		CommandList commandList;
+		RetiredEntry* next{};
+	};
+
+	const uint32_t _maxAllocatorCount;
+	const std::chrono::steady_clock::duration _idleTimeout;
+
+	std::mutex _mutex;
+	std::deque<AllocatorEntry> _allocators;
+	std::queue<CommandList> _commandLists;
+	std::atomic<RetiredEntry*> _retiredEntries{};
+	uint32_t _allocatorCount{};
+};
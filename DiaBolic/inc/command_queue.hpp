@@ -1,5 +1,9 @@
 #pragma once
 
+#include "command_list_pool.hpp"
+#include "fence_timeline.hpp"
+#include "deferred_release_queue.hpp"
+
 class CommandQueue
 {
 public:
@@ -7,35 +11,80 @@ public:
 	~CommandQueue();
 
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> GetCommandList();
-	uint64_t ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList);
+	FenceSignal ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList);
+	FenceSignal ExecuteCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists);
+
+	// Hands lists back to their pools without executing them, e.g. when recording failed halfway.
+	// Their allocators are reusable right away. Null entries are skipped.
+	void DiscardCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists);
 
-	uint64_t Signal();
-	bool IsFenceComplete(uint64_t fenceValue);
+	// The returned signal converts to the fence value and can be co_await-ed.
+	FenceSignal Signal();
+	bool IsFenceComplete(uint64_t fenceValue) const;
 	void WaitForFenceValue(uint64_t fenceValue);
+	// Returns false when the timeout expired before the fence value was reached.
+	bool WaitForFenceValue(uint64_t fenceValue, std::chrono::milliseconds timeout);
 	void Flush();
 
+	// Make this queue wait on the GPU until otherQueue reached fenceValue, the CPU doesn't block.
+	// Work submitted to this queue afterwards may use resources written by otherQueue up to that value.
+	void InsertWait(const CommandQueue& otherQueue, uint64_t fenceValue);
+
+	// Completion callbacks and awaitables for this queue's fence.
+	[[nodiscard]] FenceTimeline& GetTimeline() const { return *_timeline; }
+
+	// Objects retired here are released once this queue's fence reaches their fence value.
+	[[nodiscard]] DeferredReleaseQueue& GetDeferredReleaseQueue() const { return *_deferredReleaseQueue; }
+
+	// The fence value the next submission will signal, covers all work recorded but not yet submitted.
+	[[nodiscard]] uint64_t GetNextFenceValue();
+
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetCommandQueue() const;
+	[[nodiscard]] ID3D12Fence* GetFence() const { return _fence.Get(); }
+
+	// Command allocator usage over all threads, allocators are counted from creation until release.
+	struct AllocatorStatistics
+	{
+		uint32_t allocatorCount;
+		uint32_t highWaterMark;
+		uint64_t createdCount;
+		uint64_t releasedCount;
+	};
+	[[nodiscard]] AllocatorStatistics GetAllocatorStatistics() const;
+
 private:
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCommandAllocator();
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CreateCommandList(Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator);
 
-	// Keep track of command allocators that are "in-flight"
-	struct CommandAllocatorEntry
-	{
-		uint64_t fenceValue;
-		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
-	};
+	// Every thread that acquires command lists gets its own pool, submitters hand allocators back
+	// through a lock-free stack. The mutex is only contended when TrimPools() sweeps the pool.
+	using CommandListPool = ::CommandListPool<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>>;
 
-	using CommandAllocatorQueue = std::queue<CommandAllocatorEntry>;
-	using CommandListQueue = std::queue< Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> >;
+	CommandListPool& GetThreadPool();
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> AcquireCommandAllocator(CommandListPool& pool);
+	void TrimIdleAllocators(CommandListPool& pool, uint64_t completedFenceValue);
+	void RetireCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists, uint64_t fenceValue);
+	void TrimPools();
 
 	D3D12_COMMAND_LIST_TYPE							_commandListType;
 	Microsoft::WRL::ComPtr<ID3D12Device2>			_device;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue>		_commandQueue;
 	Microsoft::WRL::ComPtr<ID3D12Fence>				_fence;
-	HANDLE											_fenceEvent;
+	std::unique_ptr<FenceTimeline>					_timeline;
+	std::unique_ptr<DeferredReleaseQueue>			_deferredReleaseQueue;
 	uint64_t										_fenceValue;
+	const uint64_t									_queueId;
+
+	std::atomic<uint32_t>							_allocatorCount{};
+	std::atomic<uint32_t>							_allocatorHighWaterMark{};
+	std::atomic<uint64_t>							_allocatorsCreated{};
+	std::atomic<uint64_t>							_allocatorsReleased{};
+
+	std::mutex										_poolsMutex;
+	std::vector<std::unique_ptr<CommandListPool>>	_pools;
+	std::atomic<int64_t>							_nextPoolTrimTime{};
 
-	CommandAllocatorQueue							_commandAllocatorQueue;
-	CommandListQueue								_commandListQueue;
+	// Serializes submission and signaling so fence values stay in submission order.
+	std::mutex										_submitMutex;
+	std::vector<ID3D12CommandList*>					_submissionScratch;
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "resource_state_tracker.hpp"
+
+class CommandQueue;
+class DescriptorHeap;
+
+namespace Util
+{
+	class ThreadPool;
+}
+
+// Collects recording tasks that each get their own command list.
+// On Submit() the tasks are recorded in parallel on the thread pool and all
+// resulting lists are handed to the queue in a single ExecuteCommandLists call,
+// in the order the tasks were added.
+//
+// Every task records its barriers through its own ResourceStateTracker. The barriers
+// that depend on the state a resource was left in by earlier work are resolved right
+// before the lists are executed.
+//
+// Tasks may create views while they record. The views staged in the shader visible heap
+// are copied into it right before the lists are executed, so every view they index is there.
+class CommandRecorder
+{
+public:
+	using RecordFunction = std::function<void(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>&, ResourceStateTracker&)>;
+
+	CommandRecorder(CommandQueue& commandQueue, Util::ThreadPool& threadPool, DescriptorHeap& shaderVisibleHeap);
+	~CommandRecorder() = default;
+
+	CommandRecorder(const CommandRecorder& other) = delete;
+	CommandRecorder& operator=(const CommandRecorder& other) = delete;
+
+	void AddTask(RecordFunction task);
+
+	// Records all added tasks and submits them. Returns the fence value to wait for.
+	// An exception thrown by a task is rethrown here, nothing is submitted in that case
+	// and the lists that were recorded are handed back to the queue's pools.
+	uint64_t Submit();
+
+private:
+	CommandQueue& _commandQueue;
+	Util::ThreadPool& _threadPool;
+	DescriptorHeap& _shaderVisibleHeap;
+
+	std::vector<RecordFunction> _tasks;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> _commandLists;
+	std::vector<ResourceStateTracker> _trackers;
+};
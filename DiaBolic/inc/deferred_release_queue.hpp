@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+class Fence;
+
+// Keeps objects (resources, upload buffers, descriptor slots, ...) alive until the GPU
+// is done with them. Every entry is retired with the fence value of the last submission
+// that used it and released by ReleaseCompleted() once the fence reached that value.
+class DeferredReleaseQueue
+{
+public:
+	explicit DeferredReleaseQueue(const Fence& fence);
+	~DeferredReleaseQueue();
+
+	DeferredReleaseQueue(const DeferredReleaseQueue& other) = delete;
+	DeferredReleaseQueue& operator=(const DeferredReleaseQueue& other) = delete;
+
+	// The object is moved into the queue, destroying it releases it.
+	template<typename T> requires (!std::is_invocable_v<T>)
+	void Retire(uint64_t fenceValue, T object)
+	{
+		RetireEntry(fenceValue, Entry{ .object = std::make_shared<T>(std::move(object)) });
+	}
+
+	// For things that need an explicit call to be freed, such as descriptor slots.
+	void Retire(uint64_t fenceValue, std::function<void()> release)
+	{
+		RetireEntry(fenceValue, Entry{ .release = std::move(release) });
+	}
+
+	// For work that is recorded but not submitted yet, the entry is retired by the
+	// next RetireUnsubmitted() call with the fence value of that submission.
+	template<typename T> requires (!std::is_invocable_v<T>)
+	void RetireOnSubmit(T object)
+	{
+		RetireUnsubmittedEntry(Entry{ .object = std::make_shared<T>(std::move(object)) });
+	}
+
+	void RetireOnSubmit(std::function<void()> release)
+	{
+		RetireUnsubmittedEntry(Entry{ .release = std::move(release) });
+	}
+
+	// Call with the fence value returned by the submission of the recorded work.
+	void RetireUnsubmitted(uint64_t fenceValue);
+
+	// Releases every entry whose fence value completed. Returns the amount of entries released.
+	size_t ReleaseCompleted();
+
+	// Releases everything regardless of the fence, unsubmitted entries included. Only call this once the GPU is idle.
+	void ReleaseAll();
+
+	[[nodiscard]] size_t GetPendingCount() const;
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<void> object{};
+		std::function<void()> release{};
+	};
+
+	void RetireEntry(uint64_t fenceValue, Entry entry);
+	void RetireUnsubmittedEntry(Entry entry);
+	static void Release(std::multimap<uint64_t, Entry>& entries);
+
+	const Fence& _fence;
+
+	mutable std::mutex _mutex;
+	std::multimap<uint64_t, Entry> _entries;
+	std::vector<Entry> _unsubmittedEntries;
+};
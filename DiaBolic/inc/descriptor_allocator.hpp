@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// A single descriptor or a contiguous range of descriptors handed out by a DescriptorAllocator.
+// The generation is the one of the first slot when it was allocated, freeing the slot bumps it,
+// so a handle (or a bindless index derived from it) that outlived its descriptor can be detected.
+struct DescriptorAllocation
+{
+	uint32_t index{};
+	uint32_t count{};
+	uint32_t generation{};
+
+	[[nodiscard]] bool IsNull() const { return count == 0; }
+};
+
+// Hands out descriptor slots of a heap with a fixed capacity.
+// Freed single slots and freed ranges are kept in free lists keyed by their size, so allocating
+// and freeing is O(1) as long as a freed range of the requested size (or the untouched tail) exists.
+// Otherwise the free lists are searched for a larger range that is split, and as a last resort
+// they're compacted, which merges adjacent free ranges.
+// With a page size, ranges never cross a page boundary, for heaps that are made of separate pages.
+class DescriptorAllocator
+{
+public:
+	explicit DescriptorAllocator(uint32_t capacity, uint32_t pageSize = 0);
+	~DescriptorAllocator() = default;
+
+	DescriptorAllocator(const DescriptorAllocator& other) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+	// Returns a null allocation when there is no contiguous range of the requested size left.
+	[[nodiscard]] DescriptorAllocation Allocate(uint32_t count = 1);
+	void Free(const DescriptorAllocation& allocation);
+
+	// False once the allocation was freed.
+	[[nodiscard]] bool IsValid(const DescriptorAllocation& allocation) const;
+
+	// Merges adjacent free ranges and gives free ranges at the end back to the untouched tail.
+	// Live allocations are never moved, so their indices stay valid.
+	void Compact();
+
+	// Adds slots to the end, everything that was handed out stays where it is.
+	void Grow(uint32_t capacity);
+
+	// Generation a slot that is allocated right now carries.
+	[[nodiscard]] uint32_t GetGeneration(uint32_t index) const { return _generations[index]; }
+
+	[[nodiscard]] uint32_t GetCapacity() const { return _capacity; }
+	[[nodiscard]] uint32_t GetAllocatedCount() const { return _allocatedCount; }
+
+private:
+	struct FreeRange
+	{
+		uint32_t index;
+		uint32_t count;
+	};
+
+	[[nodiscard]] DescriptorAllocation TryAllocate(uint32_t count);
+	[[nodiscard]] DescriptorAllocation MakeAllocation(uint32_t index, uint32_t count);
+	void AddFreeRange(uint32_t index, uint32_t count);
+
+	uint32_t _capacity;
+	uint32_t _pageSize;
+	uint32_t _allocatedCount{};
+
+	// Everything from here to the end of the heap was never handed out.
+	uint32_t _top{};
+
+	std::vector<uint32_t> _generations;
+
+	// Freed slots by the size of the range they were part of.
+	std::vector<uint32_t> _freeIndices;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> _freeRanges;
+};
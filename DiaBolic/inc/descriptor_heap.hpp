@@ -1,5 +1,7 @@
 #pragma once
 
+#include "descriptor_allocator.hpp"
+
 struct DescriptorHandle
 {
     D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle{};
@@ -14,12 +16,20 @@ struct DescriptorHandle
     }
 };
 
+// A shader visible heap can be backed by a CPU only staging heap (stagingDescriptorCount > 0).
+// Views are then created in the staging heap and copied to the shader visible heap in batches by
+// FlushStagedDescriptors(). The staging heap is made of pages of stagingDescriptorCount descriptors,
+// pages are added on demand up to the size of the shader visible heap and never move.
+//
+// Allocating, freeing, staging and creating views is safe from any thread. Single descriptors come
+// from a small per-thread cache, so threads creating views at the same time rarely share a lock.
 class DescriptorHeap
 {
 public:
     DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType,
-                                uint32_t descriptorCount, const std::wstring& descriptorHeapName);
-    ~DescriptorHeap() = default;
+                                uint32_t descriptorCount, const std::wstring& descriptorHeapName,
+                                uint32_t stagingDescriptorCount = 0u);
+    ~DescriptorHeap();
 
     DescriptorHeap(const DescriptorHeap& other) = delete;
     DescriptorHeap& operator=(const DescriptorHeap& other) = delete;
@@ -42,28 +52,86 @@ public:
         return _descriptorHandleFromHeapStart;
     };
 
-    [[nodiscard]] DescriptorHandle GetCurrentDescriptorHandle() const
-    {
-        return _currentDescriptorHandle;
-    };
-
     [[nodiscard]] DescriptorHandle GetDescriptorHandleFromIndex(const uint32_t index) const;
+    [[nodiscard]] DescriptorHandle GetDescriptorHandle(const DescriptorAllocation& allocation) const;
 
     // Returns a index that can be used to directly index into a descriptor heap.
     [[nodiscard]] uint32_t GetDescriptorIndex(const DescriptorHandle& descriptorHandle) const;
-    [[nodiscard]] uint32_t GetCurrentDescriptorIndex() const;
 
     // Used to offset a X_Handle passed into function.
     void OffsetDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& handle, const uint32_t offset = 1u) const;
     void OffsetDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE& handle, const uint32_t offset = 1u) const;
     void OffsetDescriptor(DescriptorHandle& handle, const uint32_t offset = 1u) const;
 
-    void OffsetCurrentHandle(const uint32_t offset = 1u);
+    // Allocates a single descriptor or a contiguous range, throws when the heap is full.
+    [[nodiscard]] DescriptorAllocation Allocate(const uint32_t count = 1u);
+
+    // The GPU must be done with the descriptors, see Renderer::ReleaseDescriptor().
+    void Free(const DescriptorAllocation& allocation);
+
+    // False for allocations that were freed, use this to catch stale bindless indices.
+    [[nodiscard]] bool IsValid(const DescriptorAllocation& allocation) const;
+
+    void Compact();
+
+    // Where views for the allocation should be created, the shader visible heap itself when there is no staging heap.
+    [[nodiscard]] D3D12_CPU_DESCRIPTOR_HANDLE GetStagingDescriptorHandle(const DescriptorAllocation& allocation) const;
+
+    // Queues the staged descriptors of the allocation to be copied by the next flush.
+    void StageDescriptors(const DescriptorAllocation& allocation);
+
+    // Copies all staged descriptors with a single CopyDescriptors call, adjacent ranges are merged.
+    // Has to run between creating a view and executing a command list that indexes it.
+    void FlushStagedDescriptors();
+
+    [[nodiscard]] uint32_t GetDescriptorCount() const;
+    [[nodiscard]] uint32_t GetAllocatedDescriptorCount() const;
 
 private:
+    // Single descriptors reserved by one thread, only that thread touches it.
+    struct ThreadDescriptorCache
+    {
+        std::vector<DescriptorAllocation> descriptors;
+    };
+
+    // The caches of one thread in every heap, gives their descriptors back when the thread exits.
+    struct ThreadCacheTable;
+
+    struct StagedEntry
+    {
+        DescriptorAllocation allocation;
+        StagedEntry* next{};
+    };
+
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _descriptorHeap{};
     uint32_t _descriptorSize{};
 
     DescriptorHandle _descriptorHandleFromHeapStart{};
-    DescriptorHandle _currentDescriptorHandle{};
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> _device{};
+    D3D12_DESCRIPTOR_HEAP_TYPE _descriptorHeapType{};
+    uint32_t _descriptorCount{};
+    std::wstring _descriptorHeapName{};
+    const uint64_t _heapId;
+
+    mutable std::mutex _allocatorMutex;
+    DescriptorAllocator _allocator;
+
+    std::mutex _threadCachesMutex;
+    std::vector<std::unique_ptr<ThreadDescriptorCache>> _threadCaches;
+
+    // Pages are only added while holding _allocatorMutex, before the allocator hands out their slots.
+    uint32_t _stagingPageSize{};
+    std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> _stagingPages;
+    std::unique_ptr<D3D12_CPU_DESCRIPTOR_HANDLE[]> _stagingPageStarts;
+
+    // Lock-free stack, pushed by any thread and emptied by FlushStagedDescriptors().
+    std::atomic<StagedEntry*> _stagedEntries{};
+
+    [[nodiscard]] DescriptorAllocation TryAllocateLocked(const uint32_t count);
+    [[nodiscard]] DescriptorAllocation AllocateLocked(const uint32_t count);
+    [[nodiscard]] ThreadDescriptorCache& GetThreadCache();
+    void RefillThreadCache(ThreadDescriptorCache& cache);
+    void ReleaseThreadCache(ThreadDescriptorCache& cache);
+    void AddStagingPage();
 };
\ No newline at end of file
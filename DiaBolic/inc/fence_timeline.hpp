@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class FenceWaiter;
+
+// Something that wakes the fence waiter thread. On Windows this is an event so
+// D3D12 fences can set it directly through SetEventOnCompletion.
+class WakeSignal
+{
+public:
+	WakeSignal();
+	~WakeSignal();
+
+	WakeSignal(const WakeSignal& other) = delete;
+	WakeSignal& operator=(const WakeSignal& other) = delete;
+
+	void Set();
+	void Wait();
+
+#ifdef _WIN32
+	[[nodiscard]] void* GetNativeHandle() const { return _event; }
+#endif
+
+private:
+#ifdef _WIN32
+	void* _event{};
+#else
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _signaled{};
+#endif
+};
+
+// Monotonic GPU (or simulated) timeline the FenceTimeline observes.
+class Fence
+{
+public:
+	virtual ~Fence() = default;
+
+	[[nodiscard]] virtual uint64_t GetCompletedValue() const = 0;
+
+	// Arrange for signal to be set once the completed value reaches value.
+	virtual void SetWakeOnCompletion(uint64_t value, WakeSignal& signal) = 0;
+};
+
+// CPU driven fence, used to exercise the timeline without a GPU.
+class SimulatedFence : public Fence
+{
+public:
+	explicit SimulatedFence(uint64_t initialValue = 0);
+
+	[[nodiscard]] uint64_t GetCompletedValue() const override;
+	void SetWakeOnCompletion(uint64_t value, WakeSignal& signal) override;
+
+	// Completes every value up to and including value.
+	void Signal(uint64_t value);
+
+private:
+	std::atomic<uint64_t> _completedValue;
+
+	std::mutex _mutex;
+	std::vector<std::pair<uint64_t, WakeSignal*>> _wakeRequests;
+};
+
+class FenceTimeline;
+
+// Result of signaling a timeline. Converts to the raw fence value and can be co_await-ed,
+// in which case the coroutine resumes on the fence waiter thread once the value completes.
+struct FenceSignal
+{
+	FenceTimeline* timeline{};
+	uint64_t value{};
+
+	operator uint64_t() const { return value; }
+
+	[[nodiscard]] bool await_ready() const;
+	void await_suspend(std::coroutine_handle<> handle) const;
+	void await_resume() const {}
+};
+
+// Fire-and-forget coroutine type for code that co_awaits fence signals.
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+// Tracks pending work on a single fence. Completion callbacks run on the fence waiter thread,
+// or immediately on the calling thread when the value has already completed.
+class FenceTimeline
+{
+public:
+	using Callback = std::function<void()>;
+
+	explicit FenceTimeline(std::shared_ptr<Fence> fence, FenceWaiter* waiter = nullptr);
+	~FenceTimeline();
+
+	FenceTimeline(const FenceTimeline& other) = delete;
+	FenceTimeline& operator=(const FenceTimeline& other) = delete;
+
+	[[nodiscard]] uint64_t GetCompletedValue() const { return _fence->GetCompletedValue(); }
+	[[nodiscard]] bool IsComplete(uint64_t value) const { return GetCompletedValue() >= value; }
+
+	void OnCompletion(uint64_t value, Callback callback);
+
+	// Returns false if the timeout expired before the value completed.
+	bool Wait(uint64_t value, std::chrono::milliseconds timeout = (std::chrono::milliseconds::max)());
+
+	[[nodiscard]] FenceSignal Until(uint64_t value) { return FenceSignal{ this, value }; }
+
+	[[nodiscard]] Fence& GetFence() const { return *_fence; }
+
+private:
+	friend class FenceWaiter;
+
+	// Moves callbacks that completed into readyCallbacks and re-arms the fence for the rest.
+	void CollectCompleted(std::vector<Callback>& readyCallbacks, WakeSignal& wakeSignal);
+
+	std::shared_ptr<Fence> _fence;
+	FenceWaiter& _waiter;
+
+	std::mutex _mutex;
+	std::multimap<uint64_t, Callback> _pendingCallbacks;
+	uint64_t _armedValue{};
+};
+
+// Single background thread that serves every registered FenceTimeline.
+class FenceWaiter
+{
+public:
+	FenceWaiter();
+	~FenceWaiter();
+
+	FenceWaiter(const FenceWaiter& other) = delete;
+	FenceWaiter& operator=(const FenceWaiter& other) = delete;
+
+	// Process wide waiter used by timelines that don't specify their own.
+	static FenceWaiter& GetDefault();
+
+	void Wake() { _wakeSignal.Set(); }
+
+private:
+	friend class FenceTimeline;
+
+	void Register(FenceTimeline* timeline);
+	void Unregister(FenceTimeline* timeline);
+	void ThreadLoop();
+
+	WakeSignal _wakeSignal;
+
+	std::mutex _mutex;
+	std::vector<FenceTimeline*> _timelines;
+	std::atomic<bool> _stop{};
+
+	std::thread _thread;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "tlsf_allocator.hpp"
+
+// Heaps are split by what they may contain, resource heap tier 1 hardware can't mix these.
+enum class HeapTier : uint8_t
+{
+	Buffers,
+	Textures,
+	RenderTargets,
+	Count,
+};
+
+// Memory a resource was placed in. The resource itself is owned by whoever created it.
+struct GpuAllocation
+{
+	HeapTier tier{};
+	uint32_t blockIndex{ ~0u };
+	TlsfAllocator::Allocation range{};
+
+	// Resources too large for a block are committed and have no range.
+	[[nodiscard]] bool IsPlaced() const { return !range.IsNull(); }
+};
+
+// Sub-allocates placed resources out of large default heaps instead of giving every resource
+// its own implicit heap. Every tier has its own list of blocks, each managed by a TlsfAllocator.
+// Safe to use from any thread.
+class GpuMemoryAllocator
+{
+public:
+	struct Statistics
+	{
+		uint32_t blockCount{};
+		uint32_t committedCount{};
+		TlsfAllocator::Statistics ranges{};
+	};
+
+	GpuMemoryAllocator(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t blockSize = GPU_MEMORY_BLOCK_SIZE);
+	~GpuMemoryAllocator() = default;
+
+	GpuMemoryAllocator(const GpuMemoryAllocator& other) = delete;
+	GpuMemoryAllocator& operator=(const GpuMemoryAllocator& other) = delete;
+
+	// Creates a resource in a default heap, placed when it fits in a block and committed otherwise.
+	[[nodiscard]] GpuAllocation CreateResource(const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* pClearValue, ID3D12Resource** ppResource);
+
+	// Only call this once the resource is released and the GPU is done with it.
+	void Free(const GpuAllocation& allocation);
+
+	// Heap the allocation is placed in, null for committed resources.
+	[[nodiscard]] ID3D12Heap* GetHeap(const GpuAllocation& allocation) const;
+	[[nodiscard]] uint64_t GetBlockSize() const { return _blockSize; }
+
+	// Walks every block, not meant to be called every frame.
+	[[nodiscard]] Statistics GetStatistics(HeapTier tier) const;
+	void LogStatistics() const;
+
+private:
+	struct Block
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		TlsfAllocator allocator;
+	};
+
+	struct Pool
+	{
+		// Emptied blocks are released and their slot reused, so block indices stay stable.
+		std::vector<std::unique_ptr<Block>> blocks;
+		uint32_t committedCount{};
+	};
+
+	[[nodiscard]] static HeapTier GetHeapTier(const D3D12_RESOURCE_DESC& resourceDesc);
+	[[nodiscard]] D3D12_RESOURCE_ALLOCATION_INFO GetAllocationInfo(D3D12_RESOURCE_DESC& resourceDesc) const;
+	[[nodiscard]] uint32_t CreateBlock(HeapTier tier);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> _device;
+	uint64_t _blockSize;
+
+	mutable std::mutex _mutex;
+	std::array<Pool, static_cast<size_t>(HeapTier::Count)> _pools;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+class Renderer;
+
+class ComputePipeline
+{
+public:
+	ComputePipeline(Renderer& renderer, const std::wstring& shaderPath, const std::wstring& entryPoint);
+	~ComputePipeline();
+
+	// Binds the pipeline and the bindless root signature, then dispatches with the given root constants.
+	template<typename T>
+	void Dispatch(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList, const T& resources,
+		uint32_t threadGroupCountX, uint32_t threadGroupCountY = 1u, uint32_t threadGroupCountZ = 1u) const
+	{
+		static_assert(sizeof(T) % sizeof(uint32_t) == 0 && sizeof(T) <= ROOT_CONSTANT_COUNT * sizeof(uint32_t), "Resources have to fit in the bindless root constants.");
+		Dispatch(commandList, &resources, static_cast<uint32_t>(sizeof(T) / sizeof(uint32_t)), threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+	}
+
+	void Dispatch(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList, const void* rootConstants, uint32_t rootConstantCount,
+		uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) const;
+
+private:
+	Renderer& _renderer;
+
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> _pipelineState{};
+
+	void CreatePipeline(const std::wstring& shaderPath, const std::wstring& entryPoint);
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "utility/vertex_format.hpp"
 #include "../../assets/shaders/constant_buffers.hlsli"
 
 class Renderer;
+class ComputePipeline;
 struct Camera;
 
 class GeometryPipeline
@@ -12,25 +14,34 @@ public:
 	~GeometryPipeline();
 
 	void PopulateCommandlist(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList);
+	// Records the model matrix of the current frame, runs on the async compute queue.
+	void PopulateComputeCommandlist(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList);
 	void Update(float deltaTime);
 private:
 	Renderer& _renderer;
 	std::shared_ptr<Camera> _camera;
 
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> _pipelineState{};
+	std::unique_ptr<ComputePipeline> _spinPipeline{};
+
+	// One model matrix per frame in flight, so compute never overwrites one a previous frame still reads.
+	Util::Buffer _modelBuffer{};
+	float _spinAngle{};
 
 	// temporarily stored here
-	Util::Buffer _positionBuffer{};
-	Util::Buffer _normalBuffer{};
-	Util::Buffer _uvBuffer{};
+	Util::Buffer _vertexBuffer{};
+	Util::VertexQuantization _vertexQuantization{};
 	Microsoft::WRL::ComPtr<ID3D12Resource> _indexBuffer{};
+	GpuAllocation _indexBufferMemory{};
 	D3D12_INDEX_BUFFER_VIEW _indexBufferView{};
 	uint32_t _indexCount{};
 
 	RenderResources _renderResources{};
 
 	Util::Texture _albedoTexture{};
+	DescriptorAllocation _albedoSampler{};
 
 	void CreatePipeline();
 	void InitializeAssets();
+	void CreateModelBuffer();
 };
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "transient_resource_planner.hpp"
+
+// Resource states understood by the render graph. The values match D3D12_RESOURCE_STATES,
+// so the backend can translate them with a cast.
+enum class ResourceState : uint32_t
+{
+	Common = 0x0,
+	Present = 0x0,
+	RenderTarget = 0x4,
+	UnorderedAccess = 0x8,
+	DepthWrite = 0x10,
+	DepthRead = 0x20,
+	NonPixelShaderResource = 0x40,
+	PixelShaderResource = 0x80,
+	CopyDest = 0x400,
+	CopySource = 0x800,
+};
+
+constexpr ResourceState operator|(ResourceState a, ResourceState b)
+{
+	return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+enum class ResourceAccess : uint8_t
+{
+	Read,
+	Write,		// Previous contents are discarded (e.g. a clear).
+	ReadWrite,	// Previous contents are kept (e.g. blending into a render target).
+};
+
+// Defined by the backend that executes the graph, handed to every pass callback.
+struct RenderPassContext;
+
+// Passes declare which resources they read and write, the graph then works out the order
+// of barriers and which passes can be skipped. Compilation is pure CPU work and is cached
+// for as long as the declared topology doesn't change between frames.
+class RenderGraph
+{
+public:
+	using ResourceHandle = uint32_t;
+	using ExecuteFunction = std::function<void(RenderPassContext&)>;
+
+	static constexpr ResourceHandle InvalidResource = ~0u;
+	static constexpr uint64_t InvalidOffset = ~0ull;
+
+	struct Barrier
+	{
+		ResourceHandle resource;
+		ResourceState before;
+		ResourceState after;
+		bool isUavBarrier;
+		// The transient resource takes over memory from aliasedResource, or from several earlier
+		// transient resources when that is InvalidResource.
+		bool isAliasingBarrier{};
+		ResourceHandle aliasedResource{ InvalidResource };
+	};
+
+	struct CompiledPass
+	{
+		uint32_t passIndex;
+		std::vector<Barrier> barriers;	// Issued as one batch before the pass executes.
+	};
+
+	// Starts a new frame, passes and resources have to be declared again.
+	void Reset();
+
+	// Resources that live outside of the graph. They enter in initialState and are transitioned
+	// to finalState after the last pass. Exported resources keep the passes writing them alive.
+	ResourceHandle ImportResource(const std::string& name, void* nativeResource,
+		ResourceState initialState, ResourceState finalState, bool exported = true);
+
+	// Resources that only live within the frame. Compile() plans where they go in one heap,
+	// resources that are never used by the same range of passes share memory. They start out in state
+	// and the first pass using them has to write them in that state with ResourceAccess::Write.
+	ResourceHandle CreateTransientResource(const std::string& name, uint64_t size, uint64_t alignment, ResourceState state);
+
+	// Transient resources are created by the backend after compiling, it hands them over every frame.
+	void SetNativeResource(ResourceHandle resource, void* nativeResource);
+
+	// Adds a pass, accesses are declared on the returned index with Read/Write.
+	uint32_t AddPass(const std::string& name, ExecuteFunction execute, bool hasSideEffects = false);
+	void Read(uint32_t passIndex, ResourceHandle resource, ResourceState state);
+	void Write(uint32_t passIndex, ResourceHandle resource, ResourceState state, ResourceAccess access = ResourceAccess::ReadWrite);
+
+	// Culls unused passes and generates barriers. Returns false when the cached result was reused.
+	bool Compile();
+
+	[[nodiscard]] const std::vector<CompiledPass>& GetCompiledPasses() const { return _compiledPasses; }
+	[[nodiscard]] const std::vector<Barrier>& GetFinalBarriers() const { return _finalBarriers; }
+
+	[[nodiscard]] const ExecuteFunction& GetExecuteFunction(uint32_t passIndex) const { return _passes[passIndex].execute; }
+	[[nodiscard]] const std::string& GetPassName(uint32_t passIndex) const { return _passes[passIndex].name; }
+	[[nodiscard]] void* GetNativeResource(ResourceHandle resource) const { return _resources[resource].nativeResource; }
+
+	// Offset in the transient heap, InvalidOffset when no pass that survived culling uses the resource.
+	[[nodiscard]] uint64_t GetTransientOffset(ResourceHandle resource) const { return _transientPlacements[resource].offset; }
+	[[nodiscard]] uint64_t GetTransientHeapSize() const { return _transientPlanner.GetSize(); }
+	[[nodiscard]] uint64_t GetUnaliasedTransientSize() const { return _transientPlanner.GetUnaliasedSize(); }
+
+	[[nodiscard]] uint32_t GetPassCount() const { return static_cast<uint32_t>(_passes.size()); }
+	[[nodiscard]] uint32_t GetCulledPassCount() const { return GetPassCount() - static_cast<uint32_t>(_compiledPasses.size()); }
+
+private:
+	struct Resource
+	{
+		std::string name;
+		void* nativeResource;
+		ResourceState initialState;
+		ResourceState finalState;
+		bool exported;
+		bool transient{};
+		uint64_t size{};
+		uint64_t alignment{};
+	};
+
+	struct Access
+	{
+		ResourceHandle resource;
+		ResourceState state;
+		ResourceAccess access;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		ExecuteFunction execute;
+		bool hasSideEffects;
+		std::vector<Access> accesses;
+	};
+
+	static constexpr uint32_t NoPass = ~0u;
+
+	// Where a transient resource lives, and the first and last position in the compiled passes using it.
+	struct TransientPlacement
+	{
+		uint64_t offset{ InvalidOffset };
+		uint32_t firstUse{ NoPass };
+		uint32_t lastUse{};
+		bool isAliased{};
+		ResourceHandle aliasedResource{ InvalidResource };
+	};
+
+	[[nodiscard]] uint64_t HashTopology() const;
+	void CullPasses(std::vector<bool>& alivePasses) const;
+	void PlanTransientResources(const std::vector<bool>& alivePasses);
+	void GenerateBarriers(const std::vector<bool>& alivePasses);
+
+	std::vector<Resource> _resources;
+	std::vector<Pass> _passes;
+
+	std::vector<CompiledPass> _compiledPasses;
+	std::vector<Barrier> _finalBarriers;
+
+	// Survive Reset(), handles stay the same for as long as the topology does.
+	std::vector<TransientPlacement> _transientPlacements;
+	std::vector<ResourceHandle> _transientResources;
+	std::vector<TransientResourcePlanner::Request> _transientRequests;
+	TransientResourcePlanner _transientPlanner;
+
+	uint64_t _compiledTopologyHash{};
+	bool _hasCompiled{};
+};
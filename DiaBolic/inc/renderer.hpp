@@ -1,16 +1,46 @@
 #pragma once
 
+#include "render_graph.hpp"
+#include "descriptor_allocator.hpp"
+#include "gpu_memory_allocator.hpp"
+
 class Application;
 class GeometryPipeline;
 class UIPipeline;
+class ComputePipeline;
 class CommandQueue;
 class DescriptorHeap;
+class UploadBuffer;
+class UploadRing;
+class TransientDescriptorAllocator;
+class ViewCache;
+class ResidencyManager;
+class CommandRecorder;
+class ResourceStateTracker;
+
+namespace Util
+{
+    class ThreadPool;
+}
 struct Camera;
 
+// Constants that live in the current frame's constant ring until the GPU finished the frame.
+struct DynamicConstantBuffer
+{
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress{};
+    uint32_t cbvIndex{};    // Transient CBV, for ResourceDescriptorHeap[].
+};
+
+// Handed to render graph passes while they record.
+struct RenderPassContext
+{
+    const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList;
+};
+
 class Renderer
 {
 public:
-	Renderer(std::shared_ptr<Application> app);
+	Renderer(std::shared_ptr<Application> app, uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
 	~Renderer();
 
     void Update(float deltaTime);
@@ -18,7 +48,54 @@ public:
 
     void Flush();
 
+    // Number of frames the CPU is allowed to record ahead of the GPU.
+    // Independent from the amount of swapchain back buffers (FRAME_COUNT).
+    void SetFramesInFlight(uint32_t framesInFlight);
+    [[nodiscard]] uint32_t GetFramesInFlight() const { return _framesInFlight; }
+
+    // Records work on the async compute queue, it overlaps with graphics work until it's joined.
+    // The command list comes with the bindless heaps set. Returns the compute fence value of the work.
+    uint64_t SubmitAsyncCompute(const std::function<void(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>&)>& record);
+
+    // Makes graphics work submitted after this call wait (on the GPU) for the async compute work.
+    void JoinAsyncCompute(uint64_t computeFenceValue);
+
+    // Releases the resource once the direct queue finished all work recorded up to now,
+    // instead of flushing the GPU. Work is retired with the fence value of the next frame's submission.
+    // Its global resource state is dropped together with it.
+    void DeferRelease(Microsoft::WRL::ComPtr<ID3D12Resource> resource);
+
+    // Same as above for resources created through the GpuMemoryAllocator, their memory is freed right after them.
+    void DeferRelease(Microsoft::WRL::ComPtr<ID3D12Resource> resource, const GpuAllocation& memory);
+
+    // Drops a reference to a CBV/SRV/UAV, the last one frees it once the direct queue
+    // finished all work recorded up to now.
+    void ReleaseDescriptor(const DescriptorAllocation& allocation);
+
+    // Same as above for samplers created by CreateSampler().
+    void ReleaseSampler(const DescriptorAllocation& allocation);
+
 private:
+    // Everything the CPU touches while recording a frame, kept alive until
+    // the GPU signals the fence value of that frame.
+    struct FrameContext
+    {
+        uint64_t fenceValue{};
+        uint64_t computeFenceValue{};
+        std::unique_ptr<UploadBuffer> constantRing;
+        std::unique_ptr<UploadBuffer> uploadRing;
+        std::unique_ptr<TransientDescriptorAllocator> transientDescriptors;
+    };
+
+    // Texture that only lives within a frame, placed in _transientHeap wherever the render graph planned it.
+    struct TransientTexture
+    {
+        D3D12_RESOURCE_DESC desc{};
+        D3D12_CLEAR_VALUE clearValue{};
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo{};
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    };
+
     std::shared_ptr<Application> _app;
     std::shared_ptr<Camera> _camera;
 
@@ -36,23 +113,48 @@ private:
     Microsoft::WRL::ComPtr<IDXGISwapChain3> _swapChain;
     Microsoft::WRL::ComPtr<ID3D12Device2> _device;
 
+    std::unique_ptr<GpuMemoryAllocator> _memoryAllocator;
+    std::unique_ptr<ResidencyManager> _residencyManager;
+
     std::unique_ptr<CommandQueue> _directCommandQueue;
     std::unique_ptr<CommandQueue> _copyCommandQueue;
+    std::unique_ptr<CommandQueue> _computeCommandQueue;
+
+    // Staging memory for uploads recorded on the copy queue.
+    std::unique_ptr<UploadRing> _uploadRing;
+
+    std::unique_ptr<Util::ThreadPool> _threadPool;
+    std::unique_ptr<CommandRecorder> _commandRecorder;
+    std::unique_ptr<RenderGraph> _renderGraph;
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> _bindlessRootSignature{};
 
     Microsoft::WRL::ComPtr<ID3D12Resource> _renderTargets[FRAME_COUNT];
 	uint32_t _renderTargetIndex[FRAME_COUNT];
-    Microsoft::WRL::ComPtr<ID3D12Resource> _depthTarget;
+    TransientTexture _depthTarget;
 	uint32_t _depthTargetIndex;
 
+    // Memory of the render graph's transient resources, recreated whenever its plan changes.
+    Microsoft::WRL::ComPtr<ID3D12Heap> _transientHeap;
+
 	std::unique_ptr<DescriptorHeap> _rtvHeap;
 	std::unique_ptr<DescriptorHeap> _dsvHeap;
 	std::unique_ptr<DescriptorHeap> _srvHeap;
 	std::unique_ptr<DescriptorHeap> _samplerHeap;
 
-    UINT _frameIndex;
-    uint64_t _fenceValues[FRAME_COUNT] = {};
+    // Views handed out by CreateCbv/CreateSrv/CreateUav, identical requests share a descriptor.
+    std::unique_ptr<ViewCache> _viewCache;
+
+    // Samplers in _samplerHeap, shaders index them through SamplerDescriptorHeap[].
+    std::unique_ptr<ViewCache> _samplerCache;
+
+    // Section of _srvHeap that is split between the frames in flight.
+    DescriptorAllocation _transientDescriptorRange{};
+
+    UINT _backBufferIndex;
+    uint32_t _frameIndex{};
+    uint32_t _framesInFlight;
+    std::vector<FrameContext> _frames;
     const float clearColor[4] = { 255.0f / 255.0f, 182.0f / 255.0f, 193.0f / 255.0f, 1.0f }; // pink :)
     bool _useWarpDevice;
 
@@ -60,20 +162,55 @@ private:
 	void InitializeCommandQueues();
 	void InitializeDescriptorHeaps();
     void InitializeSwapchainResources();
+    void InitializeFrameContexts();
+
+    void BeginFrame();
+    void RecordRenderGraph();
+    void RecordBarriers(ResourceStateTracker& tracker, const std::vector<RenderGraph::Barrier>& barriers) const;
+    [[nodiscard]] FrameContext& GetCurrentFrame() { return _frames[_frameIndex]; }
 
 	void CreateRenderTargets();
-	void CreateDepthTarget();
+	void InitializeTransientResources();
+	void PlaceTransientResources(RenderGraph::ResourceHandle depthTarget);
 	void CreateBindlessRootSignature();
 
-	[[nodiscard]] uint32_t CreateCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc) const;
-	[[nodiscard]] uint32_t CreateSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
-	[[nodiscard]] uint32_t CreateUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
-	[[nodiscard]] uint32_t CreateRtv(const D3D12_RENDER_TARGET_VIEW_DESC& rtvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
-	[[nodiscard]] uint32_t CreateDsv(const D3D12_DEPTH_STENCIL_VIEW_DESC& dsvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
+	[[nodiscard]] DescriptorAllocation CreateCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc) const;
+	[[nodiscard]] DescriptorAllocation CreateSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
+	[[nodiscard]] DescriptorAllocation CreateUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
+	[[nodiscard]] DescriptorAllocation CreateRtv(const D3D12_RENDER_TARGET_VIEW_DESC& rtvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
+	[[nodiscard]] DescriptorAllocation CreateDsv(const D3D12_DEPTH_STENCIL_VIEW_DESC& dsvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const;
+	[[nodiscard]] DescriptorAllocation CreateSampler(const D3D12_SAMPLER_DESC& samplerCreationDesc) const;
+
+	// Views that are only valid while recording the current frame, they never have to be freed.
+	[[nodiscard]] uint32_t CreateTransientCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc);
+	[[nodiscard]] uint32_t CreateTransientSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+	[[nodiscard]] uint32_t CreateTransientUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
+	// Copies the elements into the frame's upload ring and returns a transient SRV of them as a structured buffer.
+	// The stride has to be a multiple of 4 bytes.
+	[[nodiscard]] uint32_t CreateTransientStructuredBuffer(const void* elements, uint32_t elementCount, uint32_t elementStride);
+
+	// Streams the constants into the frame's constant ring, in 256 byte aligned chunks.
+	// Every pass, view or material that needs constants for this frame gets them from here.
+	[[nodiscard]] DynamicConstantBuffer AllocateConstants(const void* constants, uint32_t size);
+
+	template<typename T>
+	[[nodiscard]] DynamicConstantBuffer AllocateConstants(const T& constants)
+	{
+		return AllocateConstants(&constants, static_cast<uint32_t>(sizeof(T)));
+	}
+
+	// Residency of resources from _memoryAllocator, placed resources are tracked through their heap.
+	// Untracked resources (like render targets) are never evicted.
+	void TrackResidency(ID3D12Resource* resource, const GpuAllocation& memory);
+	void UntrackResidency(ID3D12Resource* resource, const GpuAllocation& memory);
+	// Call before Render() for everything the frame is going to use.
+	void MarkUsed(ID3D12Resource* resource, const GpuAllocation& memory);
 
 	void SetDescriptorHeaps(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList) const;
 
     // friend classes
     friend class GeometryPipeline;
     friend class UIPipeline;
+    friend class ComputePipeline;
 };
\ No newline at end of file
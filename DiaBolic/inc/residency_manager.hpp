@@ -0,0 +1,53 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "residency_tracker.hpp"
+
+class CommandQueue;
+
+// Keeps tracked heaps and committed resources within the video memory budget the OS hands out.
+// Objects that weren't used for a while are evicted when the budget shrinks or usage grows, and
+// made resident again before work that uses them is submitted. All MakeResident and Evict calls
+// of a frame are batched. Placed resources are resident with their heap, track the heap instead.
+// Safe to use from any thread.
+class ResidencyManager
+{
+public:
+	ResidencyManager(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const Microsoft::WRL::ComPtr<IDXGIAdapter3>& adapter,
+		CommandQueue& queue);
+	~ResidencyManager() = default;
+
+	ResidencyManager(const ResidencyManager& other) = delete;
+	ResidencyManager& operator=(const ResidencyManager& other) = delete;
+
+	// Tracking is reference counted, objects shared by several users (like heaps) are tracked once.
+	void Track(ID3D12Pageable* pageable, uint64_t size);
+	void Untrack(ID3D12Pageable* pageable);
+
+	// The object is used by the work submitted next.
+	void MarkUsed(ID3D12Pageable* pageable);
+
+	// Call once per frame before submitting the frame's work.
+	void Update();
+
+	// Local (dedicated) video memory, as reported by the OS.
+	[[nodiscard]] DXGI_QUERY_VIDEO_MEMORY_INFO GetVideoMemoryInfo() const;
+
+private:
+	struct TrackedObject
+	{
+		uint32_t handle;
+		uint32_t referenceCount;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> _device;
+	Microsoft::WRL::ComPtr<IDXGIAdapter3> _adapter;
+	CommandQueue& _queue;
+
+	std::mutex _mutex;
+	ResidencyTracker _tracker;
+	std::unordered_map<ID3D12Pageable*, TrackedObject> _objects;
+	std::vector<ID3D12Pageable*> _pageables;    // By tracker handle.
+	std::vector<ID3D12Pageable*> _batch;
+};
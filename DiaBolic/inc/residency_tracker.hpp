@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Residency policy without any D3D12 in it. Tracks the size of each object and when it was last
+// used, and decides which objects to make resident again and which to evict to stay within a budget.
+// Time is measured in fence values: an object used by work that signals value N is safe to evict
+// once the fence completed N. Resident objects are kept in least-recently-used order, so both
+// marking and evicting are O(1) per object.
+class ResidencyTracker
+{
+public:
+	static constexpr uint32_t InvalidHandle = ~0u;
+
+	struct Changes
+	{
+		std::vector<uint32_t> makeResident;
+		std::vector<uint32_t> evict;
+	};
+
+	ResidencyTracker() = default;
+	~ResidencyTracker() = default;
+
+	ResidencyTracker(const ResidencyTracker& other) = delete;
+	ResidencyTracker& operator=(const ResidencyTracker& other) = delete;
+
+	// Objects start out resident, as if they were used by the work that signals fenceValue.
+	[[nodiscard]] uint32_t Add(uint64_t size, uint64_t fenceValue);
+	void Remove(uint32_t handle);
+
+	// An evicted object is made resident again by the next Update().
+	void MarkUsed(uint32_t handle, uint64_t fenceValue);
+
+	// Evicts least recently used objects until the resident size fits in the budget. Objects used
+	// after completedFenceValue might still be accessed by the GPU and are never evicted, so the
+	// resident size can stay over the budget.
+	[[nodiscard]] Changes Update(uint64_t budget, uint64_t completedFenceValue);
+
+	[[nodiscard]] bool IsResident(uint32_t handle) const { return _entries[handle].isResident; }
+	[[nodiscard]] uint64_t GetResidentSize() const { return _residentSize; }
+	[[nodiscard]] uint64_t GetTrackedSize() const { return _trackedSize; }
+
+private:
+	struct Entry
+	{
+		uint64_t size{};
+		uint64_t lastUsedFenceValue{};
+		// Neighbours in the least-recently-used list, only resident objects are in it.
+		uint32_t newer{ InvalidHandle };
+		uint32_t older{ InvalidHandle };
+		bool isResident{};
+		bool isPendingResident{};
+		bool isTracked{};
+	};
+
+	void LinkNewest(uint32_t handle);
+	void Unlink(uint32_t handle);
+
+	std::vector<Entry> _entries;
+	std::vector<uint32_t> _unusedHandles;
+
+	uint32_t _newest{ InvalidHandle };
+	uint32_t _oldest{ InvalidHandle };
+
+	// Used while evicted, they count as resident already but still have to be made resident.
+	std::vector<uint32_t> _pendingResident;
+
+	uint64_t _residentSize{};
+	uint64_t _trackedSize{};
+};
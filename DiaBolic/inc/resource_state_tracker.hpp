@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+
+// Tracks the state of resources (and their subresources) while a command list is recorded.
+// Transitions are accumulated and recorded as one batched ResourceBarrier call by
+// FlushResourceBarriers(), transitions into the state a resource is already in are dropped.
+//
+// The state a resource is in when the command list starts executing isn't known while
+// recording, so the first transition of every resource, or of a subresource that wasn't used
+// yet, is kept as "pending". Right before submission the pending barriers are resolved against
+// the global (last submitted) states.
+class ResourceStateTracker
+{
+public:
+	void TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter,
+		UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+	void UAVBarrier(ID3D12Resource* resource = nullptr);
+	void AliasBarrier(ID3D12Resource* resourceBefore = nullptr, ID3D12Resource* resourceAfter = nullptr);
+
+	// Records all accumulated barriers in a single call.
+	void FlushResourceBarriers(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList);
+
+	// Only call these while the global state is locked, in submission order.
+	[[nodiscard]] std::vector<D3D12_RESOURCE_BARRIER> ResolvePendingResourceBarriers() const;
+	void CommitFinalResourceStates();
+
+	void Reset();
+
+	// The global state is shared between all trackers. The state of a resource has to be
+	// removed before the resource is released, a new one could end up at the same address.
+	[[nodiscard]] static std::unique_lock<std::mutex> LockGlobalState();
+	static void AddGlobalResourceState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+	static void RemoveGlobalResourceState(ID3D12Resource* resource);
+
+private:
+	struct TrackedState
+	{
+		explicit TrackedState(D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, bool hasWholeState = false)
+			: state(state)
+			, hasWholeState(hasWholeState)
+		{
+		}
+
+		void SetSubresourceState(UINT subresource, D3D12_RESOURCE_STATES subresourceState);
+		[[nodiscard]] D3D12_RESOURCE_STATES GetSubresourceState(UINT subresource) const;
+		// Whether the state of the subresource was set, and not just assumed from the whole resource.
+		[[nodiscard]] bool IsSubresourceKnown(UINT subresource) const;
+
+		// State of the whole resource, unless a subresource has its own entry.
+		D3D12_RESOURCE_STATES state;
+		std::map<UINT, D3D12_RESOURCE_STATES> subresourceStates;
+
+		// False while only individual subresources were transitioned.
+		bool hasWholeState;
+	};
+
+	using TrackedStateMap = std::unordered_map<ID3D12Resource*, TrackedState>;
+
+	std::vector<D3D12_RESOURCE_BARRIER> _resourceBarriers;
+	std::vector<D3D12_RESOURCE_BARRIER> _pendingResourceBarriers;
+	TrackedStateMap _finalResourceStates;
+
+	static std::mutex s_globalMutex;
+	static TrackedStateMap s_globalResourceStates;
+};
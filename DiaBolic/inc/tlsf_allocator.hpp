@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit allocator for ranges of a memory block it doesn't touch itself,
+// such as an ID3D12Heap. Allocating and freeing are O(1): free ranges are kept in lists per size
+// class, found through two levels of bitmaps, and merged with their neighbours when freed.
+class TlsfAllocator
+{
+public:
+	static constexpr uint32_t InvalidNode = ~0u;
+
+	struct Allocation
+	{
+		uint64_t offset{};
+		uint64_t size{};
+		uint32_t node{ InvalidNode };
+
+		[[nodiscard]] bool IsNull() const { return node == InvalidNode; }
+	};
+
+	struct Statistics
+	{
+		uint64_t size{};
+		uint64_t usedSize{};
+		uint64_t freeSize{};
+		uint64_t largestFreeRange{};
+		uint32_t allocationCount{};
+		uint32_t freeRangeCount{};
+
+		// 0 when all free memory is one range, close to 1 when it's scattered in small pieces.
+		[[nodiscard]] float GetFragmentation() const
+		{
+			return freeSize > 0 ? 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeSize) : 0.0f;
+		}
+	};
+
+	explicit TlsfAllocator(uint64_t size);
+	~TlsfAllocator() = default;
+
+	TlsfAllocator(const TlsfAllocator& other) = delete;
+	TlsfAllocator& operator=(const TlsfAllocator& other) = delete;
+
+	TlsfAllocator(TlsfAllocator&& other) = default;
+	TlsfAllocator& operator=(TlsfAllocator&& other) = default;
+
+	// Alignment has to be a power of two. Returns a null allocation when no free range fits.
+	[[nodiscard]] Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+	void Free(const Allocation& allocation);
+
+	[[nodiscard]] bool IsEmpty() const { return _allocationCount == 0; }
+	[[nodiscard]] uint64_t GetSize() const { return _size; }
+
+	// Walks every range, not meant to be called every frame.
+	[[nodiscard]] Statistics GetStatistics() const;
+
+private:
+	static constexpr uint32_t SecondLevelBits = 4;
+	static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+	static constexpr uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+
+	struct Node
+	{
+		uint64_t offset{};
+		uint64_t size{};
+		uint32_t previousPhysical{ InvalidNode };
+		uint32_t nextPhysical{ InvalidNode };
+		uint32_t previousFree{ InvalidNode };
+		uint32_t nextFree{ InvalidNode };
+		bool isFree{};
+	};
+
+	static void Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+	[[nodiscard]] uint32_t FindFreeNode(uint64_t size) const;
+
+	[[nodiscard]] uint32_t CreateNode(uint64_t offset, uint64_t size);
+	void DestroyNode(uint32_t node);
+
+	void InsertFreeNode(uint32_t node);
+	void RemoveFreeNode(uint32_t node);
+
+	// Cuts the front off a node, the front becomes a new node placed before it.
+	[[nodiscard]] uint32_t SplitFront(uint32_t node, uint64_t size);
+
+	uint64_t _size;
+	uint32_t _allocationCount{};
+
+	std::vector<Node> _nodes;
+	std::vector<uint32_t> _unusedNodes;
+	uint32_t _firstNode{ InvalidNode };
+
+	uint64_t _firstLevelBitmap{};
+	std::array<uint32_t, FirstLevelCount> _secondLevelBitmaps{};
+	std::array<uint32_t, FirstLevelCount * SecondLevelCount> _freeLists{};
+};
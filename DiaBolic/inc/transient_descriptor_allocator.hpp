@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands out descriptors from a fixed range of a shader visible heap that only live for one frame.
+// Allocating is a lock-free bump, so passes recording in parallel can share it.
+// There is no way to free a single descriptor, the owner calls Reset() once the GPU finished the frame.
+class TransientDescriptorAllocator
+{
+public:
+	TransientDescriptorAllocator(uint32_t firstIndex, uint32_t count);
+	~TransientDescriptorAllocator() = default;
+
+	TransientDescriptorAllocator(const TransientDescriptorAllocator& other) = delete;
+	TransientDescriptorAllocator& operator=(const TransientDescriptorAllocator& other) = delete;
+
+	// Returns the heap index of the first of count contiguous descriptors.
+	[[nodiscard]] uint32_t Allocate(uint32_t count = 1);
+	void Reset();
+
+	[[nodiscard]] uint32_t GetCount() const { return _count; }
+	[[nodiscard]] uint32_t GetUsedCount() const { return _offset.load(std::memory_order_relaxed); }
+
+private:
+	uint32_t _firstIndex;
+	uint32_t _count;
+
+	std::atomic<uint32_t> _offset{};
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Packs resources that only live for part of a frame into one block of memory. Resources whose
+// lifetimes (inclusive ranges of pass positions) overlap get disjoint memory, everything else may
+// share it. Placement is greedy by size: the largest resource goes first, each one at the lowest
+// offset that doesn't collide with an already placed resource it lives at the same time as.
+class TransientResourcePlanner
+{
+public:
+	static constexpr uint32_t NoResource = ~0u;
+
+	struct Request
+	{
+		uint64_t size;
+		uint64_t alignment;		// Power of two.
+		uint32_t firstPass;
+		uint32_t lastPass;
+	};
+
+	struct Placement
+	{
+		uint64_t offset{};
+		// Set when memory of a resource that lived earlier is reused, which needs an aliasing barrier.
+		bool isAliased{};
+		// The resource that used the memory before, NoResource when there were several.
+		uint32_t aliasedResource{ NoResource };
+	};
+
+	// Placements are in the same order as the requests.
+	void Plan(std::span<const Request> requests);
+
+	[[nodiscard]] const std::vector<Placement>& GetPlacements() const { return _placements; }
+	[[nodiscard]] uint64_t GetSize() const { return _size; }
+
+	// What the resources would take without aliasing, without any padding for alignment.
+	[[nodiscard]] uint64_t GetUnaliasedSize() const { return _unaliasedSize; }
+
+private:
+	std::vector<Placement> _placements;
+	uint64_t _size{};
+	uint64_t _unaliasedSize{};
+
+	// Scratch, kept around so planning every frame doesn't allocate.
+	std::vector<uint32_t> _order;
+	std::vector<uint32_t> _placed;
+	std::vector<uint32_t> _collisions;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "fence_timeline.hpp"
+#include "gpu_memory_allocator.hpp"
+
+class CommandQueue;
+class UploadRing;
+
+// Collects buffer and texture uploads and copies all of them at once: their data is packed into
+// a single upload ring allocation and every copy is recorded into one copy command list.
+// Destinations are created right away, so views can be made for them before the batch is submitted.
+class UploadBatch
+{
+public:
+	UploadBatch(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, GpuMemoryAllocator& memoryAllocator,
+		UploadRing& uploadRing, CommandQueue& copyQueue);
+	~UploadBatch();
+
+	UploadBatch(const UploadBatch& other) = delete;
+	UploadBatch& operator=(const UploadBatch& other) = delete;
+
+	// The data is read in Submit(), it has to stay valid until then.
+	void AddBuffer(ID3D12Resource** ppDestination, GpuAllocation& destinationMemory,
+		const void* data, size_t size, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+	// The decoded image is kept by the batch until Submit().
+	void AddTextureFromFile(ID3D12Resource** ppDestination, GpuAllocation& destinationMemory,
+		const std::wstring& fileName, DXGI_FORMAT& format);
+
+	// Records and executes every copy added since the previous submission.
+	// Destinations can be used once the copy queue reached the returned fence value.
+	FenceSignal Submit();
+
+	[[nodiscard]] bool IsEmpty() const { return _uploads.empty(); }
+
+private:
+	struct Upload
+	{
+		ID3D12Resource* destination{};
+		uint64_t stagingOffset{};
+
+		// Buffers
+		const void* data{};
+		uint64_t size{};
+
+		// Textures
+		std::unique_ptr<DirectX::ScratchImage> image;
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+		std::vector<UINT> rowCounts;
+		std::vector<UINT64> rowSizes;
+	};
+
+	[[nodiscard]] uint64_t ReserveStaging(uint64_t size, uint64_t alignment);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> _device;
+	GpuMemoryAllocator& _memoryAllocator;
+	UploadRing& _uploadRing;
+	CommandQueue& _copyQueue;
+
+	std::vector<Upload> _uploads;
+	uint64_t _stagingSize{};
+};
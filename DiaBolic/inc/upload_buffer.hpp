@@ -0,0 +1,42 @@
+#pragma once
+
+// Persistently mapped buffer in an UPLOAD heap that is sub-allocated linearly.
+// The owner is responsible for only calling Reset() once the GPU is done with
+// every allocation made since the previous Reset().
+// Allocating is lock-free, so threads recording in parallel can share one buffer.
+// The memory is write-combined: write it sequentially and never read it back.
+class UploadBuffer
+{
+public:
+	struct Allocation
+	{
+		void* cpuAddress{};
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress{};
+		uint64_t offset{};
+		ID3D12Resource* resource{};
+	};
+
+	UploadBuffer(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t size, const std::wstring& name);
+	~UploadBuffer();
+
+	UploadBuffer(const UploadBuffer& other) = delete;
+	UploadBuffer& operator=(const UploadBuffer& other) = delete;
+
+	UploadBuffer(UploadBuffer&& other) = delete;
+	UploadBuffer& operator=(UploadBuffer&& other) = delete;
+
+	[[nodiscard]] Allocation Allocate(uint64_t size, uint64_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	void Reset();
+
+	[[nodiscard]] uint64_t GetSize() const { return _size; }
+	[[nodiscard]] uint64_t GetUsedSize() const { return _offset.load(std::memory_order_relaxed); }
+	[[nodiscard]] ID3D12Resource* GetResource() const { return _resource.Get(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> _resource{};
+	uint8_t* _cpuAddress{};
+	D3D12_GPU_VIRTUAL_ADDRESS _gpuAddress{};
+
+	uint64_t _size{};
+	std::atomic<uint64_t> _offset{};
+};
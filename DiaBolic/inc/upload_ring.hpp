@@ -0,0 +1,54 @@
+#pragma once
+
+#include "upload_buffer.hpp"
+
+class CommandQueue;
+
+// Persistently mapped UPLOAD heap buffer that staging data for copies is sub-allocated from
+// linearly, wrapping around at the end. Memory is reclaimed once the queue's fence reaches the
+// value it was submitted with, when the ring is full the oldest submission is waited on.
+// Allocations and their Submit() are expected to come from one thread at a time,
+// otherwise another thread's submission could reclaim memory its copies still read from.
+class UploadRing
+{
+public:
+	using Allocation = UploadBuffer::Allocation;
+
+	UploadRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandQueue& queue, uint64_t size, const std::wstring& name);
+	~UploadRing();
+
+	UploadRing(const UploadRing& other) = delete;
+	UploadRing& operator=(const UploadRing& other) = delete;
+
+	[[nodiscard]] Allocation Allocate(uint64_t size, uint64_t alignment = D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT);
+
+	// Everything allocated since the previous call is read by work that signals fenceValue on the queue.
+	void Submit(uint64_t fenceValue);
+
+	[[nodiscard]] uint64_t GetSize() const { return _size; }
+	[[nodiscard]] uint64_t GetUsedSize() const;
+
+private:
+	struct Submission
+	{
+		uint64_t fenceValue;
+		uint64_t end;
+	};
+
+	void Reclaim(uint64_t completedFenceValue);
+
+	CommandQueue& _queue;
+	Microsoft::WRL::ComPtr<ID3D12Resource> _resource{};
+	uint8_t* _cpuAddress{};
+	D3D12_GPU_VIRTUAL_ADDRESS _gpuAddress{};
+	uint64_t _size{};
+
+	// Positions only ever grow, the offset in the buffer is the position modulo the size.
+	// Everything from _head up to _tail is in use.
+	uint64_t _head{};
+	uint64_t _tail{};
+	uint64_t _submittedTail{};
+	std::deque<Submission> _submissions;
+
+	mutable std::mutex _mutex;
+};
@@ -6,6 +6,9 @@ namespace Util
 
     void CheckFeatureSupport(const Microsoft::WRL::ComPtr<ID3D12Device>& device);
 
+    // Largest shader visible CBV/SRV/UAV heap the resource binding tier of the device guarantees.
+    [[nodiscard]] uint32_t GetMaxShaderVisibleDescriptorCount(const Microsoft::WRL::ComPtr<ID3D12Device>& device);
+
 
     inline void ThrowIfFailed(HRESULT hr)
     {
@@ -1,22 +1,27 @@
 #pragma once
 
+#include "descriptor_allocator.hpp"
+#include "gpu_memory_allocator.hpp"
+
 namespace Util
 {
 	struct Buffer
 	{
 		Microsoft::WRL::ComPtr<ID3D12Resource> resource{};
+		GpuAllocation memory{};
 
-		uint32_t srvIndex{};
-		uint32_t uavIndex{};
-		uint32_t cbvIndex{};
+		DescriptorAllocation srv{};
+		DescriptorAllocation uav{};
+		DescriptorAllocation cbv{};
 	};
 
 	struct Texture
 	{
 		Microsoft::WRL::ComPtr<ID3D12Resource> resource{};
+		GpuAllocation memory{};
 
-		uint32_t srvIndex{};
-		uint32_t uavIndex{};
+		DescriptorAllocation srv{};
+		DescriptorAllocation uav{};
 	};
 
 	void CreateCube(std::vector<DirectX::XMFLOAT3>& vertices,
@@ -24,18 +29,6 @@ namespace Util
 		std::vector<DirectX::XMFLOAT2>& uvs,
 		std::vector<uint16_t>& indices, float size);
 
-	void LoadBufferResource(Microsoft::WRL::ComPtr<ID3D12Device> device,
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-		ID3D12Resource** pDestinationResource, ID3D12Resource** pIntermediateResource, 
-		size_t numElements, size_t elementSize, const void* bufferData, 
-		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
-
-	void LoadTextureFromFile(Microsoft::WRL::ComPtr<ID3D12Device> device, 
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-		ID3D12Resource** pDestinationResource, ID3D12Resource** pIntermediateResource,
-		const std::wstring& filePath, DXGI_FORMAT& format);
-	
-	void TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList, 
-		Microsoft::WRL::ComPtr<ID3D12Resource> resource, 
-		D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
+	// Decodes a .dds, .hdr, .tga or WIC image and returns the description of a texture that holds it.
+	[[nodiscard]] D3D12_RESOURCE_DESC LoadImageFromFile(const std::wstring& fileName, DirectX::ScratchImage& scratchImage);
 }
\ No newline at end of file
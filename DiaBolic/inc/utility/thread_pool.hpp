@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Util
+{
+	// Small fixed-size pool of worker threads used to spread CPU work
+	// (e.g. command list recording) over multiple cores.
+	class ThreadPool
+	{
+	public:
+		// A worker count of 0 spawns one worker per hardware thread, minus the calling thread.
+		explicit ThreadPool(uint32_t workerCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+
+		// Runs task(0) .. task(taskCount - 1) spread over the workers and the calling thread.
+		// Blocks until every task has finished. If tasks threw, the first exception is rethrown
+		// here once all of them are done.
+		void Execute(uint32_t taskCount, const std::function<void(uint32_t)>& task);
+
+		[[nodiscard]] uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+	private:
+		void WorkerLoop();
+		void RunTasks();
+
+		std::vector<std::thread> _workers;
+
+		std::mutex _mutex;
+		std::condition_variable _wakeCondition;
+		std::condition_variable _doneCondition;
+
+		const std::function<void(uint32_t)>* _task{};
+		uint32_t _taskCount{};
+		uint32_t _nextTask{};
+		uint32_t _finishedTasks{};
+		uint64_t _generation{};
+		std::exception_ptr _exception;
+		bool _stop{};
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Util
+{
+	// Interleaved vertex of 12 bytes, unpacked by vertex_format.hlsli.
+	// positionXY:      x and y as 16 bit unorm, relative to the mesh bounds (VertexQuantization).
+	// positionZNormal: z as 16 bit unorm, then the octahedral encoded normal as two 8 bit snorm values.
+	// uv:              u and v as half floats.
+	struct PackedVertex
+	{
+		uint32_t positionXY;
+		uint32_t positionZNormal;
+		uint32_t uv;
+	};
+	static_assert(sizeof(PackedVertex) == 12, "PackedVertex has to match the shader side.");
+
+	// Per mesh dequantization: position = offset + quantized * scale.
+	struct VertexQuantization
+	{
+		float offset[3]{};
+		float scale[3]{};
+	};
+
+	// Covers the bounds of the positions, tightly packed xyz floats.
+	[[nodiscard]] VertexQuantization ComputeVertexQuantization(std::span<const float> positions);
+
+	[[nodiscard]] PackedVertex PackVertex(const float position[3], const float normal[3], const float uv[2],
+		const VertexQuantization& quantization);
+	void UnpackVertex(const PackedVertex& vertex, const VertexQuantization& quantization,
+		float position[3], float normal[3], float uv[2]);
+
+	// Positions and normals are tightly packed xyz floats, uvs tightly packed uv floats.
+	[[nodiscard]] std::vector<PackedVertex> PackVertices(std::span<const float> positions, std::span<const float> normals,
+		std::span<const float> uvs, VertexQuantization& quantization);
+
+	// Normal doesn't have to be normalized, the decoded one is.
+	[[nodiscard]] uint16_t EncodeOctahedral(const float normal[3]);
+	void DecodeOctahedral(uint16_t encoded, float normal[3]);
+
+	// Round to nearest even, same as f32tof16 in HLSL.
+	[[nodiscard]] uint16_t FloatToHalf(float value);
+	[[nodiscard]] float HalfToFloat(uint16_t value);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
+#include "descriptor_allocator.hpp"
+
+enum class ViewType : uint8_t
+{
+	Cbv,
+	Srv,
+	Uav,
+	Sampler,
+};
+
+// Packs the fields that identify a view tightly into a cache key. Keys are compared bitwise,
+// writing field by field keeps padding and unused union members out of the comparison.
+class ViewKeyWriter
+{
+public:
+	static constexpr size_t MaxSize = 64;
+
+	explicit ViewKeyWriter(std::array<uint8_t, MaxSize>& bytes)
+		: _bytes(bytes)
+	{
+	}
+
+	template<typename... Values>
+	void Write(const Values&... values)
+	{
+		(WriteBytes(values), ...);
+	}
+
+	[[nodiscard]] uint32_t GetSize() const { return _size; }
+
+private:
+	template<typename Value>
+	void WriteBytes(const Value& value)
+	{
+		static_assert(std::is_arithmetic_v<Value> || std::has_unique_object_representations_v<Value>,
+			"Value has padding, write its fields one by one.");
+		assert(_size + sizeof(Value) <= MaxSize && "View description is too large to be cached.");
+
+		std::memcpy(_bytes.data() + _size, &value, sizeof(Value));
+		_size += static_cast<uint32_t>(sizeof(Value));
+	}
+
+	std::array<uint8_t, MaxSize>& _bytes;
+	uint32_t _size{};
+};
+
+// View descriptions without padding are written as a whole. Descriptions with padding
+// or unions overload this next to their type and write only the fields in use.
+template<typename ViewDesc>
+void WriteViewKey(ViewKeyWriter& writer, const ViewDesc& desc)
+{
+	writer.Write(desc);
+}
+
+// Deduplicates views: requesting the same view of the same resource again returns the
+// descriptor that already exists and adds a reference to it.
+// Only the fields WriteViewKey() writes are compared, so callers don't have to zero-initialize
+// their view descriptions. Views have to be released before their resource,
+// a new resource at the same address would otherwise get the old descriptor.
+//
+// Safe to use from any thread, the entries are split into shards that are locked separately.
+class ViewCache
+{
+public:
+	ViewCache() = default;
+	~ViewCache() = default;
+
+	ViewCache(const ViewCache& other) = delete;
+	ViewCache& operator=(const ViewCache& other) = delete;
+
+	// Returns a null allocation when the view isn't cached yet.
+	template<typename ViewDesc>
+	[[nodiscard]] DescriptorAllocation Acquire(ViewType type, const void* resource, const ViewDesc& desc)
+	{
+		return Acquire(MakeKey(type, resource, desc));
+	}
+
+	// Caches a newly created view, holding one reference. When another thread cached the same view
+	// in the meantime, a reference to that one is returned instead and the new view should be freed.
+	template<typename ViewDesc>
+	[[nodiscard]] DescriptorAllocation Add(ViewType type, const void* resource, const ViewDesc& desc, const DescriptorAllocation& allocation)
+	{
+		return Add(MakeKey(type, resource, desc), allocation);
+	}
+
+	// Returns true when this was the last reference and the descriptor should be freed.
+	[[nodiscard]] bool Release(const DescriptorAllocation& allocation);
+
+	[[nodiscard]] size_t GetViewCount() const;
+
+private:
+	static constexpr size_t ShardCount = 16;
+
+	struct Key
+	{
+		ViewType type{};
+		const void* resource{};
+		uint32_t descSize{};
+		std::array<uint8_t, ViewKeyWriter::MaxSize> desc{};
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		DescriptorAllocation allocation;
+		uint32_t referenceCount;
+	};
+
+	template<typename ViewDesc>
+	static Key MakeKey(ViewType type, const void* resource, const ViewDesc& desc)
+	{
+		Key key{ .type = type, .resource = resource };
+		ViewKeyWriter writer(key.desc);
+		WriteViewKey(writer, desc);
+		key.descSize = writer.GetSize();
+		return key;
+	}
+
+	struct EntryShard
+	{
+		mutable std::mutex mutex;
+		std::unordered_map<Key, Entry, KeyHash> entries;
+	};
+
+	// Descriptor index to the entry that owns it, for releasing.
+	struct KeyShard
+	{
+		std::mutex mutex;
+		std::unordered_map<uint32_t, Key> keys;
+	};
+
+	[[nodiscard]] DescriptorAllocation Acquire(const Key& key);
+	[[nodiscard]] DescriptorAllocation Add(const Key& key, const DescriptorAllocation& allocation);
+
+	[[nodiscard]] EntryShard& GetEntryShard(const Key& key) { return _entryShards[KeyHash{}(key) % ShardCount]; }
+	[[nodiscard]] KeyShard& GetKeyShard(uint32_t index) { return _keyShards[index % ShardCount]; }
+
+	std::array<EntryShard, ShardCount> _entryShards;
+	std::array<KeyShard, ShardCount> _keyShards;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "view_cache.hpp"
+
+// Cache keys of the D3D12 view descriptions. Only the fields of the active view dimension are
+// written, the padding and the rest of the union are left unspecified by designated initializers.
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc);
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc);
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_UNORDERED_ACCESS_VIEW_DESC& desc);
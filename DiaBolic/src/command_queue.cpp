@@ -3,13 +3,51 @@
 #include "utility/dx12_helpers.hpp"
 
 #include <queue>
+#include <unordered_map>
 
 using namespace Util;
 
+namespace
+{
+    // Used to store the owning CommandListPool in the private data of a command list.
+    // {8C1B0E36-4C5A-4E4B-9F0B-2D4E61A3C7D5}
+    constexpr GUID CommandListPoolGuid = { 0x8c1b0e36, 0x4c5a, 0x4e4b, { 0x9f, 0x0b, 0x2d, 0x4e, 0x61, 0xa3, 0xc7, 0xd5 } };
+
+    // Ids are never reused, so a stale entry in a thread's lookup table can't alias a new queue.
+    std::atomic<uint64_t> g_nextQueueId{ 1 };
+
+    // How often submissions sweep the pools of all threads.
+    constexpr auto PoolTrimInterval = std::chrono::milliseconds(100);
+
+    // Exposes a D3D12 fence to the fence timeline.
+    class D3D12Fence : public Fence
+    {
+    public:
+        explicit D3D12Fence(Microsoft::WRL::ComPtr<ID3D12Fence> fence)
+            : _fence(std::move(fence))
+        {
+        }
+
+        uint64_t GetCompletedValue() const override
+        {
+            return _fence->GetCompletedValue();
+        }
+
+        void SetWakeOnCompletion(uint64_t value, WakeSignal& signal) override
+        {
+            ThrowIfFailed(_fence->SetEventOnCompletion(value, signal.GetNativeHandle()));
+        }
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12Fence> _fence;
+    };
+}
+
 CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2>& device, D3D12_COMMAND_LIST_TYPE type)
     : _fenceValue(0)
     , _commandListType(type)
     , _device(device)
+    , _queueId(g_nextQueueId++)
 {
     // Describe and create the command queue.
     // https://www.3dgep.com/learning-directx-12-1/#Command_Queue
@@ -22,24 +60,31 @@ CommandQueue::CommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2>& device, D3D12_
     ThrowIfFailed(_device->CreateCommandQueue(&desc, IID_PPV_ARGS(&_commandQueue)));
     ThrowIfFailed(_device->CreateFence(_fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)));
 
-    _fenceEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
-    assert(_fenceEvent && "Failed to create fence event handle.");
+    _timeline = std::make_unique<FenceTimeline>(std::make_shared<D3D12Fence>(_fence));
+    _deferredReleaseQueue = std::make_unique<DeferredReleaseQueue>(_timeline->GetFence());
 }
 
 CommandQueue::~CommandQueue()
 {
 	WaitForFenceValue(_fenceValue);
-	CloseHandle(_fenceEvent);
+	_deferredReleaseQueue->ReleaseAll();
 }
 
-uint64_t CommandQueue::Signal()
+FenceSignal CommandQueue::Signal()
 {
+    std::lock_guard<std::mutex> lock(_submitMutex);
     uint64_t fenceValue = ++_fenceValue;
     _commandQueue->Signal(_fence.Get(), fenceValue);
-    return fenceValue;
+    return _timeline->Until(fenceValue);
 }
 
-bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
+uint64_t CommandQueue::GetNextFenceValue()
+{
+    std::lock_guard<std::mutex> lock(_submitMutex);
+    return _fenceValue + 1;
+}
+
+bool CommandQueue::IsFenceComplete(uint64_t fenceValue) const
 {
     return _fence->GetCompletedValue() >= fenceValue;
 }
@@ -48,11 +93,29 @@ void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
     if (!IsFenceComplete(fenceValue))
     {
-        _fence->SetEventOnCompletion(fenceValue, _fenceEvent);
-        ::WaitForSingleObject(_fenceEvent, DWORD_MAX);
+        // Passing no event makes the call block until the fence is reached,
+        // which keeps concurrent waiters from stealing each other's event.
+        ThrowIfFailed(_fence->SetEventOnCompletion(fenceValue, nullptr));
     }
 }
 
+bool CommandQueue::WaitForFenceValue(uint64_t fenceValue, std::chrono::milliseconds timeout)
+{
+    return _timeline->Wait(fenceValue, timeout);
+}
+
+void CommandQueue::InsertWait(const CommandQueue& otherQueue, uint64_t fenceValue)
+{
+    if (otherQueue.IsFenceComplete(fenceValue))
+    {
+        return;
+    }
+
+    // Keep the wait ordered with respect to submissions made from other threads.
+    std::lock_guard<std::mutex> lock(_submitMutex);
+    ThrowIfFailed(_commandQueue->Wait(otherQueue.GetFence(), fenceValue));
+}
+
 void CommandQueue::Flush()
 {
     WaitForFenceValue(Signal());
@@ -63,6 +126,13 @@ Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandQueue::CreateCommandAlloca
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
     ThrowIfFailed(_device->CreateCommandAllocator(_commandListType, IID_PPV_ARGS(&commandAllocator)));
 
+    ++_allocatorsCreated;
+    const uint32_t allocatorCount = ++_allocatorCount;
+    uint32_t highWaterMark = _allocatorHighWaterMark.load(std::memory_order_relaxed);
+    while (allocatorCount > highWaterMark && !_allocatorHighWaterMark.compare_exchange_weak(highWaterMark, allocatorCount))
+    {
+    }
+
     return commandAllocator;
 }
 
@@ -74,27 +144,94 @@ Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::CreateCommandLi
     return commandList;
 }
 
-Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
+CommandQueue::CommandListPool& CommandQueue::GetThreadPool()
 {
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator;
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList;
+    // Fast path: this thread already looked up its pool for this queue.
+    thread_local std::unordered_map<uint64_t, CommandListPool*> threadPools;
+    if (auto it = threadPools.find(_queueId); it != threadPools.end())
+    {
+        return *it->second;
+    }
 
-    if (!_commandAllocatorQueue.empty() && IsFenceComplete(_commandAllocatorQueue.front().fenceValue))
+    CommandListPool* pool;
     {
-        commandAllocator = _commandAllocatorQueue.front().commandAllocator;
-        _commandAllocatorQueue.pop();
+        std::lock_guard<std::mutex> lock(_poolsMutex);
+        pool = _pools.emplace_back(std::make_unique<CommandListPool>(MAX_COMMAND_ALLOCATORS_PER_THREAD, std::chrono::seconds(COMMAND_ALLOCATOR_IDLE_SECONDS))).get();
+    }
+    threadPools.emplace(_queueId, pool);
 
-        ThrowIfFailed(commandAllocator->Reset());
+    return *pool;
+}
+
+// Reuses a completed allocator, creates one while the pool is below its cap,
+// or otherwise waits for the oldest allocator in flight.
+Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandQueue::AcquireCommandAllocator(CommandListPool& pool)
+{
+    const uint64_t completedFenceValue = _fence->GetCompletedValue();
+    TrimIdleAllocators(pool, completedFenceValue);
+
+    std::optional<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocator = pool.AcquireAllocator(completedFenceValue, [this](uint64_t fenceValue) {
+        WaitForFenceValue(fenceValue);
+    });
+
+    if (!commandAllocator)
+    {
+        return CreateCommandAllocator();
     }
-    else
+
+    ThrowIfFailed((*commandAllocator)->Reset());
+    return std::move(*commandAllocator);
+}
+
+void CommandQueue::TrimIdleAllocators(CommandListPool& pool, uint64_t completedFenceValue)
+{
+    const uint32_t releasedCount = pool.TrimIdle(completedFenceValue, std::chrono::steady_clock::now());
+
+    _allocatorCount -= releasedCount;
+    _allocatorsReleased += releasedCount;
+}
+
+// Walks the pools of every thread, so allocators are trimmed and their completion is noticed
+// even on threads that stopped acquiring command lists. Runs on submission, at most once per
+// PoolTrimInterval. Pools that are in use right now are skipped, their owner trims them itself.
+void CommandQueue::TrimPools()
+{
+    const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    const int64_t followingTrimTime = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(PoolTrimInterval).count();
+    int64_t nextTrimTime = _nextPoolTrimTime.load(std::memory_order_relaxed);
+    if (now < nextTrimTime || !_nextPoolTrimTime.compare_exchange_strong(nextTrimTime, followingTrimTime))
     {
-        commandAllocator = CreateCommandAllocator();
+        return;
     }
 
-    if (!_commandListQueue.empty())
+    const uint64_t completedFenceValue = _fence->GetCompletedValue();
+
+    std::lock_guard<std::mutex> lock(_poolsMutex);
+    for (auto& pool : _pools)
     {
-        commandList = _commandListQueue.front();
-        _commandListQueue.pop();
+        std::unique_lock<std::mutex> poolLock(pool->GetMutex(), std::try_to_lock);
+        if (poolLock.owns_lock())
+        {
+            pool->CollectRetired();
+            TrimIdleAllocators(*pool, completedFenceValue);
+        }
+    }
+}
+
+// Get a command list from the calling thread's pool.
+// Safe to call from any thread without taking a global lock once the thread's pool exists.
+Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
+{
+    CommandListPool& pool = GetThreadPool();
+    std::lock_guard<std::mutex> poolLock(pool.GetMutex());
+    pool.CollectRetired();
+
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator = AcquireCommandAllocator(pool);
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList;
+
+    if (std::optional<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> pooledCommandList = pool.AcquireCommandList())
+    {
+        commandList = std::move(*pooledCommandList);
 
         ThrowIfFailed(commandList->Reset(commandAllocator.Get(), nullptr));
     }
@@ -107,35 +244,106 @@ Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList(
     // retrieved when the command list is executed.
     ThrowIfFailed(commandList->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), commandAllocator.Get()));
 
+    // Remember which pool the command list came from so it can be returned there,
+    // even when it's submitted from another thread.
+    CommandListPool* poolPointer = &pool;
+    ThrowIfFailed(commandList->SetPrivateData(CommandListPoolGuid, sizeof(poolPointer), &poolPointer));
+
     return commandList;
 }
 
 // Execute a command list.
 // Returns the fence value to wait for for this command list.
-uint64_t CommandQueue::ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList)
+FenceSignal CommandQueue::ExecuteCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList)
 {
-    commandList->Close();
+    return ExecuteCommandLists({ &commandList, 1 });
+}
 
-    ID3D12CommandAllocator* commandAllocator;
-    UINT dataSize = sizeof(commandAllocator);
-    ThrowIfFailed(commandList->GetPrivateData(__uuidof(ID3D12CommandAllocator), &dataSize, &commandAllocator));
+// Execute a batch of command lists with a single ExecuteCommandLists call and a single signal.
+// Returns the fence value to wait for for the whole batch.
+FenceSignal CommandQueue::ExecuteCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists)
+{
+    for (const auto& commandList : commandLists)
+    {
+        ThrowIfFailed(commandList->Close());
+    }
 
-    ID3D12CommandList* const ppCommandLists[] = {
-        commandList.Get()
-    };
+    uint64_t fenceValue;
+    {
+        std::lock_guard<std::mutex> lock(_submitMutex);
 
-    _commandQueue->ExecuteCommandLists(1, ppCommandLists);
-    uint64_t fenceValue = Signal();
+        // Scratch storage is kept around between submissions so batching doesn't allocate every frame.
+        _submissionScratch.clear();
+        _submissionScratch.reserve(commandLists.size());
+        for (const auto& commandList : commandLists)
+        {
+            _submissionScratch.push_back(commandList.Get());
+        }
 
-    _commandAllocatorQueue.emplace(CommandAllocatorEntry{ fenceValue, commandAllocator });
-    _commandListQueue.push(commandList);
+        _commandQueue->ExecuteCommandLists(static_cast<UINT>(_submissionScratch.size()), _submissionScratch.data());
 
-    // The ownership of the command allocator has been transferred to the ComPtr
-    // in the command allocator queue. It is safe to release the reference 
-    // in this temporary COM pointer here.
-    commandAllocator->Release();
+        fenceValue = ++_fenceValue;
+        _commandQueue->Signal(_fence.Get(), fenceValue);
+    }
+
+    // Every allocator in the batch is retired with the same fence value.
+    RetireCommandLists(commandLists, fenceValue);
+
+    TrimPools();
+
+    return _timeline->Until(fenceValue);
+}
+
+void CommandQueue::DiscardCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists)
+{
+    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> recordedCommandLists;
+    for (const auto& commandList : commandLists)
+    {
+        if (commandList)
+        {
+            // A list that failed halfway may have recorded invalid calls and fail to close. It is
+            // closed either way, and Reset() discards whatever it recorded when it's reused.
+            commandList->Close();
+            recordedCommandLists.push_back(commandList);
+        }
+    }
+
+    // The GPU never sees these lists, fence value 0 is always complete.
+    RetireCommandLists(recordedCommandLists, 0);
+}
 
-    return fenceValue;
+// Hands each list and its allocator back to the pool of the thread that acquired it.
+void CommandQueue::RetireCommandLists(std::span<const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>> commandLists, uint64_t fenceValue)
+{
+    for (const auto& commandList : commandLists)
+    {
+        ID3D12CommandAllocator* commandAllocator;
+        UINT dataSize = sizeof(commandAllocator);
+        ThrowIfFailed(commandList->GetPrivateData(__uuidof(ID3D12CommandAllocator), &dataSize, &commandAllocator));
+
+        // Drop the list's own reference so trimming the allocator actually frees its memory.
+        ThrowIfFailed(commandList->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), nullptr));
+
+        CommandListPool* pool;
+        dataSize = sizeof(pool);
+        ThrowIfFailed(commandList->GetPrivateData(CommandListPoolGuid, &dataSize, &pool));
+
+        // GetPrivateData already added a reference, so hand it over as is
+        // instead of taking and releasing another one.
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> retiredAllocator;
+        retiredAllocator.Attach(commandAllocator);
+        pool->Retire(std::move(retiredAllocator), commandList, fenceValue);
+    }
+}
+
+CommandQueue::AllocatorStatistics CommandQueue::GetAllocatorStatistics() const
+{
+    return AllocatorStatistics{
+        .allocatorCount = _allocatorCount.load(),
+        .highWaterMark = _allocatorHighWaterMark.load(),
+        .createdCount = _allocatorsCreated.load(),
+        .releasedCount = _allocatorsReleased.load(),
+    };
 }
 
 Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetCommandQueue() const
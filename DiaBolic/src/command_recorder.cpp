@@ -0,0 +1,87 @@
+#include "command_recorder.hpp"
+
+#include "command_queue.hpp"
+#include "descriptor_heap.hpp"
+#include "utility/thread_pool.hpp"
+
+CommandRecorder::CommandRecorder(CommandQueue& commandQueue, Util::ThreadPool& threadPool, DescriptorHeap& shaderVisibleHeap)
+    : _commandQueue(commandQueue)
+    , _threadPool(threadPool)
+    , _shaderVisibleHeap(shaderVisibleHeap)
+{
+}
+
+void CommandRecorder::AddTask(RecordFunction task)
+{
+    _tasks.emplace_back(std::move(task));
+}
+
+uint64_t CommandRecorder::Submit()
+{
+    // Each worker acquires its command list from its own pool, so nothing here is serialized.
+    _commandLists.clear();
+    _commandLists.resize(_tasks.size());
+    if (_trackers.size() < _tasks.size())
+    {
+        _trackers.resize(_tasks.size());
+    }
+
+    try
+    {
+        _threadPool.Execute(static_cast<uint32_t>(_tasks.size()), [this](uint32_t taskIndex) {
+            ResourceStateTracker& tracker = _trackers[taskIndex];
+            tracker.Reset();
+
+            _commandLists[taskIndex] = _commandQueue.GetCommandList();
+            _tasks[taskIndex](_commandLists[taskIndex], tracker);
+            tracker.FlushResourceBarriers(_commandLists[taskIndex]);
+        });
+    }
+    catch (...)
+    {
+        // The half recorded lists go back to their pools unsubmitted, so a failed frame doesn't
+        // keep their allocators counted against the cap. The next frame starts with a clean recorder.
+        _commandQueue.DiscardCommandLists(_commandLists);
+        _tasks.clear();
+        _commandLists.clear();
+        throw;
+    }
+
+    // The global states must not change between resolving the pending barriers and executing the lists.
+    const std::unique_lock<std::mutex> globalStateLock = ResourceStateTracker::LockGlobalState();
+
+    // The pending barriers of a list are recorded at the end of the list before it, which is still open.
+    // Only the first list needs an extra list in front of it, and only if it has pending barriers.
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> fixupCommandList;
+    for (size_t i = 0; i < _commandLists.size(); ++i)
+    {
+        const std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers = _trackers[i].ResolvePendingResourceBarriers();
+        if (!pendingBarriers.empty())
+        {
+            if (i == 0)
+            {
+                fixupCommandList = _commandQueue.GetCommandList();
+            }
+
+            const auto& commandList = i == 0 ? fixupCommandList : _commandLists[i - 1];
+            commandList->ResourceBarrier(static_cast<UINT>(pendingBarriers.size()), pendingBarriers.data());
+        }
+
+        _trackers[i].CommitFinalResourceStates();
+    }
+
+    if (fixupCommandList)
+    {
+        _commandLists.insert(_commandLists.begin(), fixupCommandList);
+    }
+
+    // Views created by the tasks become visible to shaders before the lists that index them run.
+    _shaderVisibleHeap.FlushStagedDescriptors();
+
+    const uint64_t fenceValue = _commandQueue.ExecuteCommandLists(_commandLists);
+
+    _tasks.clear();
+    _commandLists.clear();
+
+    return fenceValue;
+}
\ No newline at end of file
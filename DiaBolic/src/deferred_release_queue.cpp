@@ -0,0 +1,96 @@
+#include "deferred_release_queue.hpp"
+
+#include "fence_timeline.hpp"
+
+DeferredReleaseQueue::DeferredReleaseQueue(const Fence& fence)
+    : _fence(fence)
+{
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+    ReleaseAll();
+}
+
+void DeferredReleaseQueue::RetireEntry(uint64_t fenceValue, Entry entry)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.emplace(fenceValue, std::move(entry));
+}
+
+void DeferredReleaseQueue::RetireUnsubmittedEntry(Entry entry)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _unsubmittedEntries.emplace_back(std::move(entry));
+}
+
+void DeferredReleaseQueue::RetireUnsubmitted(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (Entry& entry : _unsubmittedEntries)
+    {
+        _entries.emplace(fenceValue, std::move(entry));
+    }
+    _unsubmittedEntries.clear();
+}
+
+size_t DeferredReleaseQueue::ReleaseCompleted()
+{
+    const uint64_t completedValue = _fence.GetCompletedValue();
+
+    // Entries are released outside of the lock, releasing might retire new entries.
+    std::multimap<uint64_t, Entry> completedEntries;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto firstPending = _entries.upper_bound(completedValue);
+        if (firstPending == _entries.begin())
+        {
+            return 0;
+        }
+
+        auto node = _entries.begin();
+        while (node != firstPending)
+        {
+            completedEntries.insert(_entries.extract(node++));
+        }
+    }
+
+    const size_t releasedCount = completedEntries.size();
+    Release(completedEntries);
+
+    return releasedCount;
+}
+
+void DeferredReleaseQueue::ReleaseAll()
+{
+    std::multimap<uint64_t, Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        entries.swap(_entries);
+        for (Entry& entry : _unsubmittedEntries)
+        {
+            entries.emplace(0, std::move(entry));
+        }
+        _unsubmittedEntries.clear();
+    }
+
+    Release(entries);
+}
+
+size_t DeferredReleaseQueue::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size() + _unsubmittedEntries.size();
+}
+
+void DeferredReleaseQueue::Release(std::multimap<uint64_t, Entry>& entries)
+{
+    for (auto& [fenceValue, entry] : entries)
+    {
+        if (entry.release)
+        {
+            entry.release();
+        }
+    }
+    entries.clear();
+}
@@ -0,0 +1,175 @@
+#include "descriptor_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t capacity, uint32_t pageSize)
+    : _capacity(capacity)
+    , _pageSize(pageSize)
+    , _generations(capacity, 0u)
+{
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(uint32_t count)
+{
+    assert(count > 0 && "Can't allocate zero descriptors.");
+    assert((_pageSize == 0 || count <= _pageSize) && "Descriptor range doesn't fit in a page.");
+
+    DescriptorAllocation allocation = TryAllocate(count);
+    if (allocation.IsNull())
+    {
+        // The free ranges might just be too fragmented.
+        Compact();
+        allocation = TryAllocate(count);
+    }
+
+    return allocation;
+}
+
+void DescriptorAllocator::Free(const DescriptorAllocation& allocation)
+{
+    assert(IsValid(allocation) && "Descriptor allocation was already freed.");
+
+    for (uint32_t i = allocation.index; i < allocation.index + allocation.count; ++i)
+    {
+        ++_generations[i];
+    }
+
+    AddFreeRange(allocation.index, allocation.count);
+    _allocatedCount -= allocation.count;
+}
+
+bool DescriptorAllocator::IsValid(const DescriptorAllocation& allocation) const
+{
+    return !allocation.IsNull() &&
+        allocation.index + allocation.count <= _top &&
+        _generations[allocation.index] == allocation.generation;
+}
+
+void DescriptorAllocator::Compact()
+{
+    std::vector<FreeRange> freeRanges;
+    freeRanges.reserve(_freeIndices.size());
+    for (const uint32_t index : _freeIndices)
+    {
+        freeRanges.push_back({ index, 1u });
+    }
+    for (const auto& [count, indices] : _freeRanges)
+    {
+        for (const uint32_t index : indices)
+        {
+            freeRanges.push_back({ index, count });
+        }
+    }
+
+    _freeIndices.clear();
+    _freeRanges.clear();
+
+    std::sort(freeRanges.begin(), freeRanges.end(), [](const FreeRange& a, const FreeRange& b) {
+        return a.index < b.index;
+    });
+
+    std::vector<FreeRange> mergedRanges;
+    for (const FreeRange& range : freeRanges)
+    {
+        const bool startsPage = _pageSize > 0 && range.index % _pageSize == 0;
+        if (!mergedRanges.empty() && !startsPage && mergedRanges.back().index + mergedRanges.back().count == range.index)
+        {
+            mergedRanges.back().count += range.count;
+        }
+        else
+        {
+            mergedRanges.push_back(range);
+        }
+    }
+
+    if (!mergedRanges.empty() && mergedRanges.back().index + mergedRanges.back().count == _top)
+    {
+        _top = mergedRanges.back().index;
+        mergedRanges.pop_back();
+    }
+
+    for (const FreeRange& range : mergedRanges)
+    {
+        AddFreeRange(range.index, range.count);
+    }
+}
+
+void DescriptorAllocator::Grow(uint32_t capacity)
+{
+    assert(capacity >= _capacity && "Descriptor allocators can't shrink.");
+
+    _capacity = capacity;
+    _generations.resize(capacity, 0u);
+}
+
+DescriptorAllocation DescriptorAllocator::TryAllocate(uint32_t count)
+{
+    // A freed range of exactly this size.
+    if (count == 1 && !_freeIndices.empty())
+    {
+        const uint32_t index = _freeIndices.back();
+        _freeIndices.pop_back();
+        return MakeAllocation(index, count);
+    }
+
+    if (const auto it = _freeRanges.find(count); it != _freeRanges.end() && !it->second.empty())
+    {
+        const uint32_t index = it->second.back();
+        it->second.pop_back();
+        return MakeAllocation(index, count);
+    }
+
+    // The part of the heap that was never used.
+    uint32_t index = _top;
+    if (_pageSize > 0 && count > 1 && index / _pageSize != (index + count - 1) / _pageSize)
+    {
+        // Skip to the next page, the rest of this one is still good for smaller ranges.
+        index = (index / _pageSize + 1) * _pageSize;
+    }
+
+    if (index <= _capacity && count <= _capacity - index)
+    {
+        if (index > _top)
+        {
+            AddFreeRange(_top, index - _top);
+        }
+
+        _top = index + count;
+        return MakeAllocation(index, count);
+    }
+
+    // Split a larger freed range.
+    for (auto& [rangeCount, indices] : _freeRanges)
+    {
+        if (rangeCount > count && !indices.empty())
+        {
+            const uint32_t rangeIndex = indices.back();
+            const uint32_t remainingCount = rangeCount - count;
+            indices.pop_back();
+
+            AddFreeRange(rangeIndex + count, remainingCount);
+            return MakeAllocation(rangeIndex, count);
+        }
+    }
+
+    return {};
+}
+
+DescriptorAllocation DescriptorAllocator::MakeAllocation(uint32_t index, uint32_t count)
+{
+    _allocatedCount += count;
+    return DescriptorAllocation{ .index = index, .count = count, .generation = _generations[index] };
+}
+
+void DescriptorAllocator::AddFreeRange(uint32_t index, uint32_t count)
+{
+    if (count == 1)
+    {
+        _freeIndices.push_back(index);
+    }
+    else
+    {
+        _freeRanges[count].push_back(index);
+    }
+}
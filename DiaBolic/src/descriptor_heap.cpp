@@ -2,8 +2,51 @@
 
 #include "utility/dx12_helpers.hpp"
 
+#include <unordered_map>
+
+namespace
+{
+    // Ids are never reused, so a stale entry in a thread's lookup table can't alias a new heap.
+    std::atomic<uint64_t> g_nextHeapId{ 1 };
+
+    // Heaps that are alive, exiting threads only give their descriptors back to these.
+    std::mutex g_liveHeapsMutex;
+    std::unordered_map<uint64_t, DescriptorHeap*> g_liveHeaps;
+}
+
+struct DescriptorHeap::ThreadCacheTable
+{
+    ThreadCacheTable() = default;
+    ThreadCacheTable(const ThreadCacheTable& other) = delete;
+    ThreadCacheTable& operator=(const ThreadCacheTable& other) = delete;
+
+    ~ThreadCacheTable()
+    {
+        // Holding the lock keeps the heaps from being destroyed while their caches are released.
+        std::lock_guard<std::mutex> lock(g_liveHeapsMutex);
+        for (const auto& [heapId, cache] : caches)
+        {
+            if (auto it = g_liveHeaps.find(heapId); it != g_liveHeaps.end())
+            {
+                it->second->ReleaseThreadCache(*cache);
+            }
+        }
+    }
+
+    // Heaps are looked up by id, a thread can create views in any amount of heaps.
+    std::unordered_map<uint64_t, ThreadDescriptorCache*> caches;
+};
+
 DescriptorHeap::DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType,
-                                   const uint32_t descriptorCount, const std::wstring& descriptorHeapName)
+                                   const uint32_t descriptorCount, const std::wstring& descriptorHeapName,
+                                   const uint32_t stagingDescriptorCount)
+    : _device(device)
+    , _descriptorHeapType(descriptorHeapType)
+    , _descriptorCount(descriptorCount)
+    , _descriptorHeapName(descriptorHeapName)
+    , _heapId(g_nextHeapId++)
+    , _allocator(stagingDescriptorCount > 0 ? 0u : descriptorCount, stagingDescriptorCount)
+    , _stagingPageSize(stagingDescriptorCount)
     {
         const D3D12_DESCRIPTOR_HEAP_FLAGS descriptorHeapFlags = (descriptorHeapType == D3D12_DESCRIPTOR_HEAP_TYPE_DSV ||
                                                                  descriptorHeapType == D3D12_DESCRIPTOR_HEAP_TYPE_RTV)
@@ -27,7 +70,35 @@ DescriptorHeap::DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& devi
                                        : CD3DX12_GPU_DESCRIPTOR_HANDLE{};
         _descriptorHandleFromHeapStart.descriptorSize = _descriptorSize;
 
-        _currentDescriptorHandle = _descriptorHandleFromHeapStart;
+        if (stagingDescriptorCount > 0)
+        {
+            assert(descriptorHeapFlags == D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE && "Only shader visible heaps need a staging heap.");
+
+            const uint32_t maxStagingPageCount = (descriptorCount + stagingDescriptorCount - 1) / stagingDescriptorCount;
+            _stagingPages.reserve(maxStagingPageCount);
+            _stagingPageStarts = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(maxStagingPageCount);
+            AddStagingPage();
+        }
+
+        std::lock_guard<std::mutex> lock(g_liveHeapsMutex);
+        g_liveHeaps.emplace(_heapId, this);
+    }
+
+    DescriptorHeap::~DescriptorHeap()
+    {
+        // Threads that exit from now on leave the caches alone, they go away together with the allocator.
+        {
+            std::lock_guard<std::mutex> lock(g_liveHeapsMutex);
+            g_liveHeaps.erase(_heapId);
+        }
+
+        StagedEntry* entry = _stagedEntries.exchange(nullptr, std::memory_order_acquire);
+        while (entry)
+        {
+            StagedEntry* next = entry->next;
+            delete entry;
+            entry = next;
+        }
     }
 
     DescriptorHandle DescriptorHeap::GetDescriptorHandleFromIndex(const uint32_t index) const
@@ -38,6 +109,12 @@ DescriptorHeap::DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& devi
         return std::move(handle);
     }
 
+    DescriptorHandle DescriptorHeap::GetDescriptorHandle(const DescriptorAllocation& allocation) const
+    {
+        assert(IsValid(allocation) && "Descriptor allocation was freed.");
+        return GetDescriptorHandleFromIndex(allocation.index);
+    }
+
     uint32_t DescriptorHeap::GetDescriptorIndex(const DescriptorHandle& descriptorHandle) const
     {
         return static_cast<uint32_t>(
@@ -45,11 +122,6 @@ DescriptorHeap::DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& devi
             _descriptorSize);
     }
 
-    uint32_t DescriptorHeap::GetCurrentDescriptorIndex() const
-    {
-        return GetDescriptorIndex(_currentDescriptorHandle);
-    }
-
     void DescriptorHeap::OffsetDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& handle, const uint32_t offset) const
     {
         handle.ptr += _descriptorSize * static_cast<unsigned long long>(offset);
@@ -66,7 +138,229 @@ DescriptorHeap::DescriptorHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& devi
         descriptorHandle.gpuDescriptorHandle.ptr += _descriptorSize * static_cast<unsigned long long>(offset);
     }
 
-    void DescriptorHeap::OffsetCurrentHandle(const uint32_t offset)
+    DescriptorAllocation DescriptorHeap::Allocate(const uint32_t count)
+    {
+        if (count == 1)
+        {
+            ThreadDescriptorCache& cache = GetThreadCache();
+            if (cache.descriptors.empty())
+            {
+                RefillThreadCache(cache);
+            }
+
+            const DescriptorAllocation allocation = cache.descriptors.back();
+            cache.descriptors.pop_back();
+            return allocation;
+        }
+
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        return AllocateLocked(count);
+    }
+
+    void DescriptorHeap::Free(const DescriptorAllocation& allocation)
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        _allocator.Free(allocation);
+    }
+
+    bool DescriptorHeap::IsValid(const DescriptorAllocation& allocation) const
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        return _allocator.IsValid(allocation);
+    }
+
+    void DescriptorHeap::Compact()
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        _allocator.Compact();
+    }
+
+    uint32_t DescriptorHeap::GetDescriptorCount() const
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        return _allocator.GetCapacity();
+    }
+
+    uint32_t DescriptorHeap::GetAllocatedDescriptorCount() const
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+        return _allocator.GetAllocatedCount();
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetStagingDescriptorHandle(const DescriptorAllocation& allocation) const
+    {
+        assert(IsValid(allocation) && "Descriptor allocation was freed.");
+        if (_stagingPageSize == 0)
+        {
+            return GetDescriptorHandle(allocation).cpuDescriptorHandle;
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE handle = _stagingPageStarts[allocation.index / _stagingPageSize];
+        OffsetDescriptor(handle, allocation.index % _stagingPageSize);
+        return handle;
+    }
+
+    void DescriptorHeap::StageDescriptors(const DescriptorAllocation& allocation)
+    {
+        if (_stagingPageSize == 0)
+        {
+            return;
+        }
+
+        StagedEntry* entry = new StagedEntry{ allocation };
+        entry->next = _stagedEntries.load(std::memory_order_relaxed);
+        while (!_stagedEntries.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void DescriptorHeap::FlushStagedDescriptors()
+    {
+        std::vector<DescriptorAllocation> stagedAllocations;
+        StagedEntry* entry = _stagedEntries.exchange(nullptr, std::memory_order_acquire);
+        while (entry)
+        {
+            StagedEntry* next = entry->next;
+            stagedAllocations.push_back(entry->allocation);
+            delete entry;
+            entry = next;
+        }
+
+        if (stagedAllocations.empty())
+        {
+            return;
+        }
+
+        std::sort(stagedAllocations.begin(), stagedAllocations.end(), [](const DescriptorAllocation& a, const DescriptorAllocation& b) {
+            return a.index < b.index;
+        });
+
+        // Source and destination share their indices. Ranges are merged unless that would make the
+        // source range cross into another staging page.
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> destinationRangeStarts;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sourceRangeStarts;
+        std::vector<UINT> rangeSizes;
+        uint32_t rangeEnd = 0;
+        for (const DescriptorAllocation& allocation : stagedAllocations)
+        {
+            const uint32_t allocationEnd = allocation.index + allocation.count;
+            const bool samePage = !rangeSizes.empty() &&
+                allocation.index / _stagingPageSize == (rangeEnd - 1) / _stagingPageSize;
+            if (samePage && allocation.index <= rangeEnd)
+            {
+                if (allocationEnd > rangeEnd)
+                {
+                    rangeSizes.back() += allocationEnd - rangeEnd;
+                    rangeEnd = allocationEnd;
+                }
+                continue;
+            }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE sourceRangeStart = _stagingPageStarts[allocation.index / _stagingPageSize];
+            OffsetDescriptor(sourceRangeStart, allocation.index % _stagingPageSize);
+
+            destinationRangeStarts.push_back(GetDescriptorHandleFromIndex(allocation.index).cpuDescriptorHandle);
+            sourceRangeStarts.push_back(sourceRangeStart);
+            rangeSizes.push_back(allocation.count);
+            rangeEnd = allocationEnd;
+        }
+
+        _device->CopyDescriptors(static_cast<UINT>(destinationRangeStarts.size()), destinationRangeStarts.data(), rangeSizes.data(),
+                                 static_cast<UINT>(sourceRangeStarts.size()), sourceRangeStarts.data(), rangeSizes.data(),
+                                 _descriptorHeapType);
+    }
+
+    DescriptorAllocation DescriptorHeap::TryAllocateLocked(const uint32_t count)
+    {
+        DescriptorAllocation allocation = _allocator.Allocate(count);
+        while (allocation.IsNull() && _stagingPageSize > 0 && _allocator.GetCapacity() < _descriptorCount)
+        {
+            AddStagingPage();
+            allocation = _allocator.Allocate(count);
+        }
+
+        return allocation;
+    }
+
+    DescriptorAllocation DescriptorHeap::AllocateLocked(const uint32_t count)
+    {
+        const DescriptorAllocation allocation = TryAllocateLocked(count);
+        if (allocation.IsNull())
+        {
+            throw std::exception("Descriptor heap is full.");
+        }
+
+        return allocation;
+    }
+
+    DescriptorHeap::ThreadDescriptorCache& DescriptorHeap::GetThreadCache()
     {
-        OffsetDescriptor(_currentDescriptorHandle, offset);
+        thread_local ThreadCacheTable threadCaches;
+        if (auto it = threadCaches.caches.find(_heapId); it != threadCaches.caches.end())
+        {
+            return *it->second;
+        }
+
+        ThreadDescriptorCache* cache;
+        {
+            std::lock_guard<std::mutex> lock(_threadCachesMutex);
+            cache = _threadCaches.emplace_back(std::make_unique<ThreadDescriptorCache>()).get();
+        }
+        threadCaches.caches.emplace(_heapId, cache);
+
+        return *cache;
+    }
+
+    void DescriptorHeap::RefillThreadCache(ThreadDescriptorCache& cache)
+    {
+        std::lock_guard<std::mutex> lock(_allocatorMutex);
+
+        // Reserve a whole block at once, but don't hog the last descriptors of small heaps.
+        DescriptorAllocation block = TryAllocateLocked(DESCRIPTOR_THREAD_CACHE_SIZE);
+        if (block.IsNull())
+        {
+            block = AllocateLocked(1);
+        }
+
+        // The slots of the block are freed one by one, so every one keeps its own generation.
+        for (uint32_t index = block.index + block.count; index-- > block.index;)
+        {
+            cache.descriptors.push_back(DescriptorAllocation{ .index = index, .count = 1u, .generation = _allocator.GetGeneration(index) });
+        }
+    }
+
+    void DescriptorHeap::ReleaseThreadCache(ThreadDescriptorCache& cache)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_allocatorMutex);
+            for (const DescriptorAllocation& descriptor : cache.descriptors)
+            {
+                _allocator.Free(descriptor);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_threadCachesMutex);
+        std::erase_if(_threadCaches, [&cache](const std::unique_ptr<ThreadDescriptorCache>& threadCache) {
+            return threadCache.get() == &cache;
+        });
+    }
+
+    void DescriptorHeap::AddStagingPage()
+    {
+        const uint32_t pageIndex = static_cast<uint32_t>(_stagingPages.size());
+        const uint32_t pageSize = (std::min)(_stagingPageSize, _descriptorCount - pageIndex * _stagingPageSize);
+
+        D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
+        descriptorHeapDesc.Type = _descriptorHeapType;
+        descriptorHeapDesc.NumDescriptors = pageSize;
+        descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        descriptorHeapDesc.NodeMask = 0u;
+
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> stagingPage;
+        Util::ThrowIfFailed(_device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&stagingPage)));
+        stagingPage->SetName((_descriptorHeapName + L" Staging " + std::to_wstring(pageIndex)).c_str());
+
+        _stagingPageStarts[pageIndex] = stagingPage->GetCPUDescriptorHandleForHeapStart();
+        _stagingPages.push_back(stagingPage);
+        _allocator.Grow(_allocator.GetCapacity() + pageSize);
     }
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "fence_timeline.hpp"
+
+#include <cassert>
+
+#ifdef _WIN32
+#include <windows.h>
+
+WakeSignal::WakeSignal()
+{
+    _event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+    assert(_event && "Failed to create wake event handle.");
+}
+
+WakeSignal::~WakeSignal()
+{
+    ::CloseHandle(_event);
+}
+
+void WakeSignal::Set()
+{
+    ::SetEvent(_event);
+}
+
+void WakeSignal::Wait()
+{
+    ::WaitForSingleObject(_event, INFINITE);
+}
+#else
+WakeSignal::WakeSignal() = default;
+WakeSignal::~WakeSignal() = default;
+
+void WakeSignal::Set()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _signaled = true;
+    }
+    _condition.notify_one();
+}
+
+void WakeSignal::Wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this] { return _signaled; });
+    _signaled = false;
+}
+#endif
+
+SimulatedFence::SimulatedFence(uint64_t initialValue)
+    : _completedValue(initialValue)
+{
+}
+
+uint64_t SimulatedFence::GetCompletedValue() const
+{
+    return _completedValue.load(std::memory_order_acquire);
+}
+
+void SimulatedFence::SetWakeOnCompletion(uint64_t value, WakeSignal& signal)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (GetCompletedValue() < value)
+        {
+            _wakeRequests.emplace_back(value, &signal);
+            return;
+        }
+    }
+    signal.Set();
+}
+
+void SimulatedFence::Signal(uint64_t value)
+{
+    std::vector<WakeSignal*> signals;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (value > _completedValue.load(std::memory_order_relaxed))
+        {
+            _completedValue.store(value, std::memory_order_release);
+        }
+
+        std::erase_if(_wakeRequests, [&](const std::pair<uint64_t, WakeSignal*>& request) {
+            if (request.first > value)
+            {
+                return false;
+            }
+            signals.push_back(request.second);
+            return true;
+        });
+    }
+
+    for (WakeSignal* signal : signals)
+    {
+        signal->Set();
+    }
+}
+
+bool FenceSignal::await_ready() const
+{
+    return timeline->IsComplete(value);
+}
+
+void FenceSignal::await_suspend(std::coroutine_handle<> handle) const
+{
+    timeline->OnCompletion(value, [handle]() { handle.resume(); });
+}
+
+FenceTimeline::FenceTimeline(std::shared_ptr<Fence> fence, FenceWaiter* waiter)
+    : _fence(std::move(fence))
+    , _waiter(waiter ? *waiter : FenceWaiter::GetDefault())
+{
+    _waiter.Register(this);
+}
+
+FenceTimeline::~FenceTimeline()
+{
+    _waiter.Unregister(this);
+}
+
+void FenceTimeline::OnCompletion(uint64_t value, Callback callback)
+{
+    if (IsComplete(value))
+    {
+        callback();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pendingCallbacks.emplace(value, std::move(callback));
+    }
+
+    // Let the waiter arm the fence for the new value.
+    _waiter.Wake();
+}
+
+bool FenceTimeline::Wait(uint64_t value, std::chrono::milliseconds timeout)
+{
+    if (IsComplete(value))
+    {
+        return true;
+    }
+
+    struct WaitState
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool done{};
+    };
+    auto state = std::make_shared<WaitState>();
+
+    OnCompletion(value, [state]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->done = true;
+        }
+        state->condition.notify_all();
+    });
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (timeout == (std::chrono::milliseconds::max)())
+    {
+        state->condition.wait(lock, [&] { return state->done; });
+        return true;
+    }
+
+    return state->condition.wait_for(lock, timeout, [&] { return state->done; });
+}
+
+void FenceTimeline::CollectCompleted(std::vector<Callback>& readyCallbacks, WakeSignal& wakeSignal)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_pendingCallbacks.empty())
+    {
+        return;
+    }
+
+    const uint64_t completedValue = GetCompletedValue();
+    const auto firstPending = _pendingCallbacks.upper_bound(completedValue);
+    for (auto it = _pendingCallbacks.begin(); it != firstPending; ++it)
+    {
+        readyCallbacks.emplace_back(std::move(it->second));
+    }
+    _pendingCallbacks.erase(_pendingCallbacks.begin(), firstPending);
+
+    if (_pendingCallbacks.empty())
+    {
+        return;
+    }
+
+    // Only re-arm when the earliest pending value changed, arming is not free on a real fence.
+    const uint64_t nextValue = _pendingCallbacks.begin()->first;
+    if (_armedValue <= completedValue || nextValue < _armedValue)
+    {
+        _armedValue = nextValue;
+        _fence->SetWakeOnCompletion(nextValue, wakeSignal);
+    }
+}
+
+FenceWaiter::FenceWaiter()
+    : _thread(&FenceWaiter::ThreadLoop, this)
+{
+}
+
+FenceWaiter::~FenceWaiter()
+{
+    _stop = true;
+    _wakeSignal.Set();
+    _thread.join();
+}
+
+FenceWaiter& FenceWaiter::GetDefault()
+{
+    static FenceWaiter waiter;
+    return waiter;
+}
+
+void FenceWaiter::Register(FenceTimeline* timeline)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _timelines.push_back(timeline);
+}
+
+void FenceWaiter::Unregister(FenceTimeline* timeline)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::erase(_timelines, timeline);
+}
+
+void FenceWaiter::ThreadLoop()
+{
+    std::vector<FenceTimeline::Callback> readyCallbacks;
+    while (!_stop)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (FenceTimeline* timeline : _timelines)
+            {
+                timeline->CollectCompleted(readyCallbacks, _wakeSignal);
+            }
+        }
+
+        // Run callbacks outside of any lock, they are free to register new work.
+        for (auto& callback : readyCallbacks)
+        {
+            callback();
+        }
+        const bool ranCallbacks = !readyCallbacks.empty();
+        readyCallbacks.clear();
+
+        if (!ranCallbacks)
+        {
+            _wakeSignal.Wait();
+        }
+    }
+}
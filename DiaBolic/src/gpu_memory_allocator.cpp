@@ -0,0 +1,213 @@
+#include "gpu_memory_allocator.hpp"
+
+#include "utility/dx12_helpers.hpp"
+#include "utility/log.hpp"
+
+GpuMemoryAllocator::GpuMemoryAllocator(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t blockSize)
+    : _device(device)
+    , _blockSize(blockSize)
+{
+}
+
+GpuAllocation GpuMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* pClearValue, ID3D12Resource** ppResource)
+{
+    D3D12_RESOURCE_DESC placedResourceDesc = resourceDesc;
+    const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = GetAllocationInfo(placedResourceDesc);
+
+    GpuAllocation allocation{ .tier = GetHeapTier(resourceDesc) };
+    Pool& pool = _pools[static_cast<size_t>(allocation.tier)];
+
+    if (allocationInfo.SizeInBytes > _blockSize)
+    {
+        CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+        Util::ThrowIfFailed(_device->CreateCommittedResource(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &resourceDesc,
+            initialState,
+            pClearValue,
+            IID_PPV_ARGS(ppResource)));
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++pool.committedCount;
+        return allocation;
+    }
+
+    ID3D12Heap* heap;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint32_t blockIndex = 0; blockIndex < pool.blocks.size() && allocation.range.IsNull(); ++blockIndex)
+        {
+            if (pool.blocks[blockIndex])
+            {
+                allocation.blockIndex = blockIndex;
+                allocation.range = pool.blocks[blockIndex]->allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            }
+        }
+
+        if (allocation.range.IsNull())
+        {
+            allocation.blockIndex = CreateBlock(allocation.tier);
+            allocation.range = pool.blocks[allocation.blockIndex]->allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+        }
+
+        heap = pool.blocks[allocation.blockIndex]->heap.Get();
+    }
+
+    // The block can't go away while it holds this range, so the resource can be created outside of the lock.
+    try
+    {
+        Util::ThrowIfFailed(_device->CreatePlacedResource(
+            heap,
+            allocation.range.offset,
+            &placedResourceDesc,
+            initialState,
+            pClearValue,
+            IID_PPV_ARGS(ppResource)));
+    }
+    catch (...)
+    {
+        Free(allocation);
+        throw;
+    }
+
+    return allocation;
+}
+
+void GpuMemoryAllocator::Free(const GpuAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Pool& pool = _pools[static_cast<size_t>(allocation.tier)];
+
+    if (!allocation.IsPlaced())
+    {
+        --pool.committedCount;
+        return;
+    }
+
+    std::unique_ptr<Block>& block = pool.blocks[allocation.blockIndex];
+    block->allocator.Free(allocation.range);
+
+    // Keep the first block around, releasing and recreating it all the time would be slow.
+    if (block->allocator.IsEmpty() && allocation.blockIndex > 0)
+    {
+        block.reset();
+    }
+}
+
+ID3D12Heap* GpuMemoryAllocator::GetHeap(const GpuAllocation& allocation) const
+{
+    if (!allocation.IsPlaced())
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pools[static_cast<size_t>(allocation.tier)].blocks[allocation.blockIndex]->heap.Get();
+}
+
+GpuMemoryAllocator::Statistics GpuMemoryAllocator::GetStatistics(HeapTier tier) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Pool& pool = _pools[static_cast<size_t>(tier)];
+
+    Statistics statistics{ .committedCount = pool.committedCount };
+    for (const auto& block : pool.blocks)
+    {
+        if (!block)
+        {
+            continue;
+        }
+
+        const TlsfAllocator::Statistics blockStatistics = block->allocator.GetStatistics();
+        ++statistics.blockCount;
+        statistics.ranges.size += blockStatistics.size;
+        statistics.ranges.usedSize += blockStatistics.usedSize;
+        statistics.ranges.freeSize += blockStatistics.freeSize;
+        statistics.ranges.largestFreeRange = (std::max)(statistics.ranges.largestFreeRange, blockStatistics.largestFreeRange);
+        statistics.ranges.allocationCount += blockStatistics.allocationCount;
+        statistics.ranges.freeRangeCount += blockStatistics.freeRangeCount;
+    }
+
+    return statistics;
+}
+
+void GpuMemoryAllocator::LogStatistics() const
+{
+    constexpr const char* tierNames[] = { "Buffers", "Textures", "Render Targets" };
+    for (size_t tier = 0; tier < static_cast<size_t>(HeapTier::Count); ++tier)
+    {
+        const Statistics statistics = GetStatistics(static_cast<HeapTier>(tier));
+        dblog::info("[MEMORY] {}: {} blocks, {} committed, {} / {} KiB used in {} allocations, {} free ranges, fragmentation {:.2f}",
+            tierNames[tier], statistics.blockCount, statistics.committedCount,
+            statistics.ranges.usedSize / 1024, statistics.ranges.size / 1024, statistics.ranges.allocationCount,
+            statistics.ranges.freeRangeCount, statistics.ranges.GetFragmentation());
+    }
+}
+
+HeapTier GpuMemoryAllocator::GetHeapTier(const D3D12_RESOURCE_DESC& resourceDesc)
+{
+    if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        return HeapTier::Buffers;
+    }
+
+    const bool isRenderTarget = resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+    return isRenderTarget ? HeapTier::RenderTargets : HeapTier::Textures;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO GpuMemoryAllocator::GetAllocationInfo(D3D12_RESOURCE_DESC& resourceDesc) const
+{
+    // Small textures can get away with 4KB alignment instead of 64KB, the device tells whether this one can.
+    const bool isSmallTextureCandidate = resourceDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER &&
+        resourceDesc.SampleDesc.Count <= 1 &&
+        !(resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL));
+    if (isSmallTextureCandidate)
+    {
+        resourceDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = _device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+        if (allocationInfo.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        {
+            return allocationInfo;
+        }
+    }
+
+    resourceDesc.Alignment = 0;
+    return _device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+}
+
+uint32_t GpuMemoryAllocator::CreateBlock(HeapTier tier)
+{
+    constexpr D3D12_HEAP_FLAGS tierFlags[] = {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+    };
+    constexpr const wchar_t* tierNames[] = { L"Buffers", L"Textures", L"Render Targets" };
+
+    // MSAA resources need 4MB alignment, everything else is happy with 64KB.
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = _blockSize;
+    heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = tierFlags[static_cast<size_t>(tier)];
+
+    auto block = std::make_unique<Block>(Block{ .allocator = TlsfAllocator(_blockSize) });
+    Util::ThrowIfFailed(_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&block->heap)));
+
+    Pool& pool = _pools[static_cast<size_t>(tier)];
+    const uint32_t blockIndex = static_cast<uint32_t>(std::find(pool.blocks.begin(), pool.blocks.end(), nullptr) - pool.blocks.begin());
+    block->heap->SetName((std::wstring(L"GPU Memory ") + tierNames[static_cast<size_t>(tier)] + L" " + std::to_wstring(blockIndex)).c_str());
+
+    if (blockIndex == pool.blocks.size())
+    {
+        pool.blocks.push_back(std::move(block));
+    }
+    else
+    {
+        pool.blocks[blockIndex] = std::move(block);
+    }
+
+    return blockIndex;
+}
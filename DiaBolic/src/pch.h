@@ -28,7 +28,27 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <array>
+#include <vector>
+#include <functional>
+#include <span>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <coroutine>
 
 // program specific
-#define FRAME_COUNT 2
-#define MAX_CBV_SRV_UAV_COUNT 256
\ No newline at end of file
+#define FRAME_COUNT 2                   // Number of swapchain back buffers.
+#define DEFAULT_FRAMES_IN_FLIGHT 2      // Number of frames the CPU may record ahead of the GPU.
+#define MAX_FRAMES_IN_FLIGHT 4
+#define FRAME_CONSTANT_RING_SIZE (1024 * 256)
+#define FRAME_UPLOAD_RING_SIZE (1024 * 1024 * 4)
+#define UPLOAD_RING_SIZE (1024 * 1024 * 32)   // Staging memory for copy queue uploads, reclaimed by fence.
+#define CBV_SRV_UAV_STAGING_COUNT 4096   // Descriptors per page of the CPU staging heap, pages are added up to the bindless heap size.
+#define DESCRIPTOR_THREAD_CACHE_SIZE 32  // Descriptors a thread reserves at once for creating views.
+#define TRANSIENT_DESCRIPTOR_COUNT 256     // Shared by all frames in flight.
+#define ROOT_CONSTANT_COUNT 16             // 32 bit root constants of the bindless root signature, per-draw data lives in buffers.
+#define GPU_MEMORY_BLOCK_SIZE (1024 * 1024 * 64)  // Size of the default heaps placed resources are sub-allocated from.
+#define MAX_COMMAND_ALLOCATORS_PER_THREAD 16
+#define COMMAND_ALLOCATOR_IDLE_SECONDS 5
\ No newline at end of file
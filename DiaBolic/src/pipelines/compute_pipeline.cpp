@@ -0,0 +1,47 @@
+#include "pipelines/compute_pipeline.hpp"
+
+#include "utility/dx12_helpers.hpp"
+#include "utility/shader_compiler.hpp"
+#include "renderer.hpp"
+
+using namespace Util;
+
+ComputePipeline::ComputePipeline(Renderer& renderer, const std::wstring& shaderPath, const std::wstring& entryPoint)
+    : _renderer(renderer)
+{
+    CreatePipeline(shaderPath, entryPoint);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+
+}
+
+void ComputePipeline::Dispatch(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList, const void* rootConstants, uint32_t rootConstantCount,
+    uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) const
+{
+    commandList->SetPipelineState(_pipelineState.Get());
+    commandList->SetComputeRootSignature(_renderer._bindlessRootSignature.Get());
+
+    if (rootConstantCount > 0)
+    {
+        commandList->SetComputeRoot32BitConstants(0, rootConstantCount, rootConstants, 0);
+    }
+
+    commandList->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void ComputePipeline::CreatePipeline(const std::wstring& shaderPath, const std::wstring& entryPoint)
+{
+    const auto& computeShaderBlob = ShaderCompiler::Compile(ShaderTypes::Compute, shaderPath, entryPoint).shaderBlob;
+
+    // Compute shares the bindless root signature with the graphics pipelines,
+    // the input assembler flag is simply ignored for compute.
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {
+        .pRootSignature = _renderer._bindlessRootSignature.Get(),
+        .CS = CD3DX12_SHADER_BYTECODE(computeShaderBlob->GetBufferPointer(), computeShaderBlob->GetBufferSize()),
+        .NodeMask = 0u,
+    };
+
+    ThrowIfFailed(_renderer._device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&_pipelineState)));
+}
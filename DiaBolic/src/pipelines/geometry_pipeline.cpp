@@ -1,9 +1,12 @@
 #include "utility/resource_util.hpp"
 #include "utility/dx12_helpers.hpp"
+#include "utility/vertex_format.hpp"
 
 #include "pipelines/geometry_pipeline.hpp"
+#include "pipelines/compute_pipeline.hpp"
 
 #include "command_queue.hpp"
+#include "upload_batch.hpp"
 #include "renderer.hpp"
 #include "camera.hpp"
 #include "descriptor_heap.hpp"
@@ -18,11 +21,24 @@ GeometryPipeline::GeometryPipeline(Renderer& renderer, std::shared_ptr<Camera>&
 {
     CreatePipeline();
     InitializeAssets();
+    CreateModelBuffer();
 }
 
 GeometryPipeline::~GeometryPipeline()
 {
-
+    // Frames in flight may still use all of this, it's released once the GPU is done with them.
+    _renderer.UntrackResidency(_albedoTexture.resource.Get(), _albedoTexture.memory);
+
+    _renderer.ReleaseSampler(_albedoSampler);
+    _renderer.ReleaseDescriptor(_albedoTexture.srv);
+    _renderer.ReleaseDescriptor(_vertexBuffer.srv);
+    _renderer.ReleaseDescriptor(_modelBuffer.srv);
+    _renderer.ReleaseDescriptor(_modelBuffer.uav);
+
+    _renderer.DeferRelease(std::move(_albedoTexture.resource), _albedoTexture.memory);
+    _renderer.DeferRelease(std::move(_vertexBuffer.resource), _vertexBuffer.memory);
+    _renderer.DeferRelease(std::move(_indexBuffer), _indexBufferMemory);
+    _renderer.DeferRelease(std::move(_modelBuffer.resource), _modelBuffer.memory);
 }
 
 void GeometryPipeline::PopulateCommandlist(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList)
@@ -35,15 +51,34 @@ void GeometryPipeline::PopulateCommandlist(const Microsoft::WRL::ComPtr<ID3D12Gr
     commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     commandList->IASetIndexBuffer(&_indexBufferView);
 
-    // Update the MVP matrix
-    XMMATRIX mvpMatrix = XMMatrixMultiply(_camera->model, _camera->view);
-    mvpMatrix = XMMatrixMultiply(mvpMatrix, _camera->projection);
-    _renderResources.MVP = mvpMatrix;
-    commandList->SetGraphicsRoot32BitConstants(0, 64, &_renderResources, 0);
+    // Per-view constants go in the frame's dynamic constant buffer, shared by every draw of the view.
+    ViewConstants viewConstants{};
+    viewConstants.viewProjection = XMMatrixMultiply(_camera->view, _camera->projection);
+    _renderResources.viewConstantsIndex = _renderer.AllocateConstants(viewConstants).cbvIndex;
+    _renderResources.modelIndex = _renderer._frameIndex;
+
+    // The records are written once per frame, each draw only gets its index.
+    const DrawConstants drawConstants = {
+        .drawDataIndex = _renderer.CreateTransientStructuredBuffer(&_renderResources, 1, sizeof(RenderResources)),
+        .drawIndex = 0,
+    };
+    commandList->SetGraphicsRoot32BitConstants(0, sizeof(DrawConstants) / sizeof(uint32_t), &drawConstants, 0);
 
     commandList->DrawIndexedInstanced(_indexCount, 1, 0, 0, 0);
 }
 
+void GeometryPipeline::PopulateComputeCommandlist(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList)
+{
+    // The buffer decays to common once the compute queue is done with it, so the
+    // direct queue can promote it for reading without any barriers.
+    const SpinConstants spinConstants = {
+        .modelBufferIndex = _modelBuffer.uav.index,
+        .modelIndex = _renderer._frameIndex,
+        .angle = _spinAngle,
+    };
+    _spinPipeline->Dispatch(commandList, spinConstants, 1u);
+}
+
 void GeometryPipeline::Update(float deltaTime)
 {
     static double totalTime = 0.0f;
@@ -53,16 +88,18 @@ void GeometryPipeline::Update(float deltaTime)
         totalTime = 0.0f;
     }
 
-    // Update the model matrix.
+    // The model matrix itself is built on the async compute queue.
     float angle = static_cast<float>(totalTime * 90.0);
-    const XMVECTOR rotationAxis = XMVectorSet(0, 1, 1, 0);
-    _camera->model = XMMatrixRotationAxis(rotationAxis, XMConvertToRadians(angle));
+    _spinAngle = XMConvertToRadians(angle);
 
     // Update the view matrix.
     _camera->view = XMMatrixLookAtLH(_camera->position, _camera->position + _camera->front, _camera->up);
 
     // Update the projection matrix.
     _camera->projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(_camera->fov), _renderer._aspectRatio, 0.1f, 100.0f);
+
+    // The texture is sampled this frame, it has to be resident.
+    _renderer.MarkUsed(_albedoTexture.resource.Get(), _albedoTexture.memory);
 }
 
 void GeometryPipeline::CreatePipeline()
@@ -125,11 +162,14 @@ void GeometryPipeline::CreatePipeline()
     }
 
     ThrowIfFailed(_renderer._device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&_pipelineState)));
+
+    _spinPipeline = std::make_unique<ComputePipeline>(_renderer, L"assets/shaders/cube_spin_compute.hlsl", L"CSmain");
 }
 
 void GeometryPipeline::InitializeAssets()
 {
-    auto commandList = _renderer._copyCommandQueue->GetCommandList();
+    // Everything is staged in one upload ring allocation and copied by a single command list.
+    UploadBatch uploadBatch(_renderer._device, *_renderer._memoryAllocator, *_renderer._uploadRing, *_renderer._copyCommandQueue);
 
     std::vector<XMFLOAT3> cubeVertices;
     std::vector<XMFLOAT3> cubeNormals;
@@ -137,71 +177,32 @@ void GeometryPipeline::InitializeAssets()
     std::vector<uint16_t> cubeIndices;
     CreateCube(cubeVertices, cubeNormals, cubeUVs, cubeIndices, 2.5f);
 
-    // Create the positions buffer.
-    ComPtr<ID3D12Resource> positionIntermediateBuffer;
-    LoadBufferResource(_renderer._device, commandList,
-        &_positionBuffer.resource, &positionIntermediateBuffer,
-        cubeVertices.size(), sizeof(XMFLOAT3), cubeVertices.data());
-    _positionBuffer.resource->SetName(L"Cube Positions");
-
-    const D3D12_SHADER_RESOURCE_VIEW_DESC positionDesc = {
+    // Create the interleaved, quantized vertex buffer.
+    const std::vector<PackedVertex> packedVertices = PackVertices(
+        std::span(&cubeVertices[0].x, cubeVertices.size() * 3),
+        std::span(&cubeNormals[0].x, cubeNormals.size() * 3),
+        std::span(&cubeUVs[0].x, cubeUVs.size() * 2),
+        _vertexQuantization);
+    uploadBatch.AddBuffer(&_vertexBuffer.resource, _vertexBuffer.memory,
+        packedVertices.data(), packedVertices.size() * sizeof(PackedVertex));
+    _vertexBuffer.resource->SetName(L"Cube Vertices");
+
+    const D3D12_SHADER_RESOURCE_VIEW_DESC vertexDesc = {
         .Format = DXGI_FORMAT_UNKNOWN,
         .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
         .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
         .Buffer = {
             .FirstElement = 0u,
-            .NumElements = static_cast<UINT>(cubeVertices.size()),
-            .StructureByteStride = static_cast<UINT>(sizeof(XMFLOAT3)),
+            .NumElements = static_cast<UINT>(packedVertices.size()),
+            .StructureByteStride = static_cast<UINT>(sizeof(PackedVertex)),
           },
     };
-    _positionBuffer.srvIndex = _renderer.CreateSrv(positionDesc, _positionBuffer.resource);
-
-
-    // Create the normals buffer.
-    ComPtr<ID3D12Resource> normalsIntermediateBuffer;
-    LoadBufferResource(_renderer._device, commandList,
-        &_normalBuffer.resource, &normalsIntermediateBuffer,
-        cubeNormals.size(), sizeof(XMFLOAT3), cubeNormals.data());
-    _normalBuffer.resource->SetName(L"Cube Normals");
-
-    const D3D12_SHADER_RESOURCE_VIEW_DESC normalsDesc = {
-        .Format = DXGI_FORMAT_UNKNOWN,
-        .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
-        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
-        .Buffer = {
-            .FirstElement = 0u,
-            .NumElements = static_cast<UINT>(cubeNormals.size()),
-            .StructureByteStride = static_cast<UINT>(sizeof(XMFLOAT3)),
-          },
-    };
-    _normalBuffer.srvIndex = _renderer.CreateSrv(normalsDesc, _normalBuffer.resource);
-
-
-    // Create the uvs buffer.
-    ComPtr<ID3D12Resource> uvIntermediateBuffer;
-    LoadBufferResource(_renderer._device, commandList,
-        &_uvBuffer.resource, &uvIntermediateBuffer,
-        cubeUVs.size(), sizeof(XMFLOAT2), cubeUVs.data());
-    _uvBuffer.resource->SetName(L"Cube UVs");
-
-    const D3D12_SHADER_RESOURCE_VIEW_DESC uvDesc = {
-        .Format = DXGI_FORMAT_UNKNOWN,
-        .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
-        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
-        .Buffer = {
-            .FirstElement = 0u,
-            .NumElements = static_cast<UINT>(cubeUVs.size()),
-            .StructureByteStride = static_cast<UINT>(sizeof(XMFLOAT2)),
-          },
-    };
-    _uvBuffer.srvIndex = _renderer.CreateSrv(uvDesc, _uvBuffer.resource);
+    _vertexBuffer.srv = _renderer.CreateSrv(vertexDesc, _vertexBuffer.resource);
 
 
     // Create the index buffer.
-    ComPtr<ID3D12Resource> indexIntermediateBuffer;
-    LoadBufferResource(_renderer._device, commandList,
-        &_indexBuffer, &indexIntermediateBuffer,
-        cubeIndices.size(), sizeof(uint16_t), cubeIndices.data());
+    uploadBatch.AddBuffer(&_indexBuffer, _indexBufferMemory,
+        cubeIndices.data(), cubeIndices.size() * sizeof(uint16_t));
     _indexCount = static_cast<uint32_t>(cubeIndices.size());
     _indexBuffer->SetName(L"Cube Indices");
 
@@ -212,12 +213,11 @@ void GeometryPipeline::InitializeAssets()
     };
 
     // Create the texture.
-    ComPtr<ID3D12Resource> albedoIntermediateBuffer;
     DXGI_FORMAT format{};
-    LoadTextureFromFile(_renderer._device, commandList,
-        &_albedoTexture.resource, &albedoIntermediateBuffer,
+    uploadBatch.AddTextureFromFile(&_albedoTexture.resource, _albedoTexture.memory,
         L"assets/textures/Utila.jpeg", format);
     _albedoTexture.resource->SetName(L"Utila.jpeg");
+    _renderer.TrackResidency(_albedoTexture.resource.Get(), _albedoTexture.memory);
 
     const D3D12_SHADER_RESOURCE_VIEW_DESC textureDesc = {
         .Format = format,
@@ -229,15 +229,67 @@ void GeometryPipeline::InitializeAssets()
             .PlaneSlice = 0u,
           },
     };
-    _albedoTexture.srvIndex = _renderer.CreateSrv(textureDesc, _albedoTexture.resource);
+    _albedoTexture.srv = _renderer.CreateSrv(textureDesc, _albedoTexture.resource);
+
+    const D3D12_SAMPLER_DESC samplerDesc = {
+        .Filter = D3D12_FILTER_ANISOTROPIC,
+        .AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        .AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        .AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        .MipLODBias = 0.0f,
+        .MaxAnisotropy = 16u,
+        .ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL,
+        .BorderColor = { 1.0f, 1.0f, 1.0f, 1.0f },
+        .MinLOD = 0.0f,
+        .MaxLOD = D3D12_FLOAT32_MAX,
+    };
+    _albedoSampler = _renderer.CreateSampler(samplerDesc);
 
     // Set render resources.
-    _renderResources.positionBufferIndex = _positionBuffer.srvIndex;
-    _renderResources.normalBufferIndex = _normalBuffer.srvIndex;
-    _renderResources.uvBufferIndex = _uvBuffer.srvIndex;
-    _renderResources.textureIndex = _albedoTexture.srvIndex;
-
-    // Execute list
-    uint64_t fenceValue = _renderer._copyCommandQueue->ExecuteCommandList(commandList);
-    _renderer._copyCommandQueue->WaitForFenceValue(fenceValue);
+    _renderResources.positionOffset = XMFLOAT3(_vertexQuantization.offset);
+    _renderResources.vertexBufferIndex = _vertexBuffer.srv.index;
+    _renderResources.positionScale = XMFLOAT3(_vertexQuantization.scale);
+    _renderResources.textureIndex = _albedoTexture.srv.index;
+    _renderResources.samplerIndex = _albedoSampler.index;
+
+    // Copy everything at once.
+    const uint64_t fenceValue = uploadBatch.Submit();
+
+    // Let the direct queue wait for the uploads on the GPU instead of stalling the CPU.
+    // Buffers decay back to the common state once the copy queue is done with them, and the
+    // texture is transitioned back to common explicitly, so the direct queue can promote them.
+    _renderer._directCommandQueue->InsertWait(*_renderer._copyCommandQueue, fenceValue);
+}
+
+void GeometryPipeline::CreateModelBuffer()
+{
+    const D3D12_RESOURCE_DESC modelBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
+        MAX_FRAMES_IN_FLIGHT * sizeof(XMFLOAT4X4), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    _modelBuffer.memory = _renderer._memoryAllocator->CreateResource(modelBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, &_modelBuffer.resource);
+    _modelBuffer.resource->SetName(L"Cube Model Matrices");
+
+    const D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D12_UAV_DIMENSION_BUFFER,
+        .Buffer = {
+            .FirstElement = 0u,
+            .NumElements = MAX_FRAMES_IN_FLIGHT,
+            .StructureByteStride = static_cast<UINT>(sizeof(XMFLOAT4X4)),
+          },
+    };
+    _modelBuffer.uav = _renderer.CreateUav(uavDesc, _modelBuffer.resource);
+
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+        .Buffer = {
+            .FirstElement = 0u,
+            .NumElements = MAX_FRAMES_IN_FLIGHT,
+            .StructureByteStride = static_cast<UINT>(sizeof(XMFLOAT4X4)),
+          },
+    };
+    _modelBuffer.srv = _renderer.CreateSrv(srvDesc, _modelBuffer.resource);
+
+    _renderResources.modelBufferIndex = _modelBuffer.srv.index;
 }
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "render_graph.hpp"
+
+#include <cassert>
+
+namespace
+{
+    constexpr uint32_t ReadOnlyStates = static_cast<uint32_t>(ResourceState::DepthRead) |
+                                        static_cast<uint32_t>(ResourceState::NonPixelShaderResource) |
+                                        static_cast<uint32_t>(ResourceState::PixelShaderResource) |
+                                        static_cast<uint32_t>(ResourceState::CopySource);
+
+    bool IsReadOnly(ResourceState state)
+    {
+        const uint32_t bits = static_cast<uint32_t>(state);
+        return bits != 0 && (bits & ~ReadOnlyStates) == 0;
+    }
+
+    // Read-only states can be combined, a resource in "PixelShaderResource | CopySource"
+    // can be read as either without another barrier.
+    bool Contains(ResourceState current, ResourceState requested)
+    {
+        const uint32_t requestedBits = static_cast<uint32_t>(requested);
+        return (static_cast<uint32_t>(current) & requestedBits) == requestedBits;
+    }
+
+    void HashCombine(uint64_t& hash, uint64_t value)
+    {
+        // FNV-1a over the bytes of value.
+        for (int i = 0; i < 8; ++i)
+        {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    void HashCombine(uint64_t& hash, const std::string& value)
+    {
+        for (const char c : value)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        HashCombine(hash, value.size());
+    }
+}
+
+void RenderGraph::Reset()
+{
+    _resources.clear();
+    _passes.clear();
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportResource(const std::string& name, void* nativeResource,
+    ResourceState initialState, ResourceState finalState, bool exported)
+{
+    _resources.push_back(Resource{ name, nativeResource, initialState, finalState, exported });
+    return static_cast<ResourceHandle>(_resources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateTransientResource(const std::string& name, uint64_t size, uint64_t alignment, ResourceState state)
+{
+    _resources.push_back(Resource{ name, nullptr, state, state, false, true, size, alignment });
+    return static_cast<ResourceHandle>(_resources.size() - 1);
+}
+
+void RenderGraph::SetNativeResource(ResourceHandle resource, void* nativeResource)
+{
+    assert(resource < _resources.size() && "Invalid resource handle.");
+    _resources[resource].nativeResource = nativeResource;
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, ExecuteFunction execute, bool hasSideEffects)
+{
+    _passes.push_back(Pass{ name, std::move(execute), hasSideEffects, {} });
+    return static_cast<uint32_t>(_passes.size() - 1);
+}
+
+void RenderGraph::Read(uint32_t passIndex, ResourceHandle resource, ResourceState state)
+{
+    assert(resource < _resources.size() && "Invalid resource handle.");
+    _passes[passIndex].accesses.push_back(Access{ resource, state, ResourceAccess::Read });
+}
+
+void RenderGraph::Write(uint32_t passIndex, ResourceHandle resource, ResourceState state, ResourceAccess access)
+{
+    assert(resource < _resources.size() && "Invalid resource handle.");
+    assert(access != ResourceAccess::Read && "Use Read() to declare reads.");
+    _passes[passIndex].accesses.push_back(Access{ resource, state, access });
+}
+
+bool RenderGraph::Compile()
+{
+    const uint64_t topologyHash = HashTopology();
+    if (_hasCompiled && topologyHash == _compiledTopologyHash)
+    {
+        return false;
+    }
+
+    std::vector<bool> alivePasses;
+    CullPasses(alivePasses);
+    PlanTransientResources(alivePasses);
+    GenerateBarriers(alivePasses);
+
+    _compiledTopologyHash = topologyHash;
+    _hasCompiled = true;
+
+    return true;
+}
+
+uint64_t RenderGraph::HashTopology() const
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    HashCombine(hash, _resources.size());
+    for (const Resource& resource : _resources)
+    {
+        HashCombine(hash, resource.name);
+        HashCombine(hash, static_cast<uint64_t>(resource.initialState));
+        HashCombine(hash, static_cast<uint64_t>(resource.finalState));
+        HashCombine(hash, resource.exported);
+        HashCombine(hash, resource.transient);
+        HashCombine(hash, resource.size);
+        HashCombine(hash, resource.alignment);
+    }
+
+    HashCombine(hash, _passes.size());
+    for (const Pass& pass : _passes)
+    {
+        HashCombine(hash, pass.name);
+        HashCombine(hash, pass.hasSideEffects);
+        HashCombine(hash, pass.accesses.size());
+        for (const Access& access : pass.accesses)
+        {
+            HashCombine(hash, access.resource);
+            HashCombine(hash, static_cast<uint64_t>(access.state));
+            HashCombine(hash, static_cast<uint64_t>(access.access));
+        }
+    }
+
+    return hash;
+}
+
+// Walks the passes back to front. A pass stays alive when it has side effects or writes a
+// resource that is still needed by a later pass or outside of the graph.
+void RenderGraph::CullPasses(std::vector<bool>& alivePasses) const
+{
+    alivePasses.assign(_passes.size(), false);
+
+    std::vector<bool> neededResources(_resources.size(), false);
+    for (size_t i = 0; i < _resources.size(); ++i)
+    {
+        neededResources[i] = _resources[i].exported;
+    }
+
+    for (size_t passIndex = _passes.size(); passIndex-- > 0;)
+    {
+        const Pass& pass = _passes[passIndex];
+
+        bool alive = pass.hasSideEffects;
+        for (const Access& access : pass.accesses)
+        {
+            if (access.access != ResourceAccess::Read && neededResources[access.resource])
+            {
+                alive = true;
+            }
+        }
+
+        if (!alive)
+        {
+            continue;
+        }
+        alivePasses[passIndex] = true;
+
+        // Whatever this pass fully overwrites isn't needed before it, everything it reads is.
+        for (const Access& access : pass.accesses)
+        {
+            if (access.access == ResourceAccess::Write)
+            {
+                neededResources[access.resource] = false;
+            }
+        }
+        for (const Access& access : pass.accesses)
+        {
+            if (access.access != ResourceAccess::Write)
+            {
+                neededResources[access.resource] = true;
+            }
+        }
+    }
+}
+
+// Lifetimes are counted in passes that survived culling, so a culled pass never keeps memory apart.
+void RenderGraph::PlanTransientResources(const std::vector<bool>& alivePasses)
+{
+    _transientPlacements.assign(_resources.size(), TransientPlacement{});
+
+    uint32_t position = 0;
+    for (uint32_t passIndex = 0; passIndex < _passes.size(); ++passIndex)
+    {
+        if (!alivePasses[passIndex])
+        {
+            continue;
+        }
+
+        for (const Access& access : _passes[passIndex].accesses)
+        {
+            const Resource& resource = _resources[access.resource];
+            if (!resource.transient)
+            {
+                continue;
+            }
+
+            TransientPlacement& placement = _transientPlacements[access.resource];
+            if (placement.firstUse == NoPass)
+            {
+                // Whatever the memory held before belongs to another resource.
+                assert(access.access == ResourceAccess::Write && access.state == resource.initialState &&
+                    "Transient resources have to be written in their initial state first.");
+                placement.firstUse = position;
+            }
+            placement.lastUse = position;
+        }
+        ++position;
+    }
+
+    _transientResources.clear();
+    _transientRequests.clear();
+    for (ResourceHandle resource = 0; resource < _resources.size(); ++resource)
+    {
+        if (_resources[resource].transient && _transientPlacements[resource].firstUse != NoPass)
+        {
+            const TransientPlacement& placement = _transientPlacements[resource];
+            _transientResources.push_back(resource);
+            _transientRequests.push_back({ _resources[resource].size, _resources[resource].alignment, placement.firstUse, placement.lastUse });
+        }
+    }
+
+    _transientPlanner.Plan(_transientRequests);
+
+    const auto& plannedPlacements = _transientPlanner.GetPlacements();
+    for (size_t i = 0; i < _transientResources.size(); ++i)
+    {
+        TransientPlacement& placement = _transientPlacements[_transientResources[i]];
+        placement.offset = plannedPlacements[i].offset;
+        placement.isAliased = plannedPlacements[i].isAliased;
+        if (plannedPlacements[i].aliasedResource != TransientResourcePlanner::NoResource)
+        {
+            placement.aliasedResource = _transientResources[plannedPlacements[i].aliasedResource];
+        }
+    }
+}
+
+void RenderGraph::GenerateBarriers(const std::vector<bool>& alivePasses)
+{
+    _compiledPasses.clear();
+    _finalBarriers.clear();
+
+    std::vector<uint32_t> passOrder;
+    for (uint32_t passIndex = 0; passIndex < _passes.size(); ++passIndex)
+    {
+        if (alivePasses[passIndex])
+        {
+            passOrder.push_back(passIndex);
+        }
+    }
+
+    std::vector<ResourceState> currentStates(_resources.size());
+    std::vector<bool> lastAccessWasWrite(_resources.size(), false);
+    for (size_t i = 0; i < _resources.size(); ++i)
+    {
+        currentStates[i] = _resources[i].initialState;
+    }
+
+    for (size_t orderIndex = 0; orderIndex < passOrder.size(); ++orderIndex)
+    {
+        const Pass& pass = _passes[passOrder[orderIndex]];
+        CompiledPass& compiledPass = _compiledPasses.emplace_back(CompiledPass{ passOrder[orderIndex], {} });
+
+        // Transient resources that are done go back to the state the next frame starts with,
+        // while the memory still belongs to them. Only then the next ones take it over.
+        for (const ResourceHandle resource : _transientResources)
+        {
+            if (_transientPlacements[resource].lastUse + 1 == orderIndex && currentStates[resource] != _resources[resource].finalState)
+            {
+                compiledPass.barriers.push_back(Barrier{ resource, currentStates[resource], _resources[resource].finalState, false });
+                currentStates[resource] = _resources[resource].finalState;
+            }
+        }
+        for (const ResourceHandle resource : _transientResources)
+        {
+            const TransientPlacement& placement = _transientPlacements[resource];
+            if (placement.firstUse == orderIndex && placement.isAliased)
+            {
+                compiledPass.barriers.push_back(Barrier{ resource, currentStates[resource], currentStates[resource], false, true, placement.aliasedResource });
+            }
+        }
+
+        for (const Access& access : pass.accesses)
+        {
+            const ResourceHandle resource = access.resource;
+            ResourceState& currentState = currentStates[resource];
+            const bool isWrite = access.access != ResourceAccess::Read;
+
+            if (!isWrite && IsReadOnly(access.state))
+            {
+                if (IsReadOnly(currentState) && Contains(currentState, access.state))
+                {
+                    // Already readable in this state thanks to an earlier combined transition.
+                    lastAccessWasWrite[resource] = false;
+                    continue;
+                }
+
+                // Look ahead and transition once into every read state the following readers need.
+                ResourceState targetState = access.state;
+                for (size_t nextIndex = orderIndex + 1; nextIndex < passOrder.size(); ++nextIndex)
+                {
+                    bool touchesResource = false;
+                    bool onlyReads = true;
+                    ResourceState readStates = targetState;
+                    for (const Access& nextAccess : _passes[passOrder[nextIndex]].accesses)
+                    {
+                        if (nextAccess.resource != resource)
+                        {
+                            continue;
+                        }
+                        touchesResource = true;
+                        if (nextAccess.access != ResourceAccess::Read || !IsReadOnly(nextAccess.state))
+                        {
+                            onlyReads = false;
+                            break;
+                        }
+                        readStates = readStates | nextAccess.state;
+                    }
+
+                    if (touchesResource && !onlyReads)
+                    {
+                        break;
+                    }
+                    targetState = readStates;
+                }
+
+                compiledPass.barriers.push_back(Barrier{ resource, currentState, targetState, false });
+                currentState = targetState;
+                lastAccessWasWrite[resource] = false;
+                continue;
+            }
+
+            if (currentState != access.state)
+            {
+                compiledPass.barriers.push_back(Barrier{ resource, currentState, access.state, false });
+                currentState = access.state;
+            }
+            else if (access.state == ResourceState::UnorderedAccess && (isWrite || lastAccessWasWrite[resource]))
+            {
+                // Back to back UAV accesses still need the previous writes to be visible.
+                compiledPass.barriers.push_back(Barrier{ resource, currentState, currentState, true });
+            }
+
+            lastAccessWasWrite[resource] = isWrite;
+        }
+    }
+
+    for (ResourceHandle resource = 0; resource < _resources.size(); ++resource)
+    {
+        if (currentStates[resource] != _resources[resource].finalState)
+        {
+            _finalBarriers.push_back(Barrier{ resource, currentStates[resource], _resources[resource].finalState, false });
+        }
+    }
+}
@@ -10,21 +10,36 @@
 #include "utility/resource_util.hpp"
 #include "glfw_app.hpp"
 #include "descriptor_heap.hpp"
+#include "gpu_memory_allocator.hpp"
+#include "residency_manager.hpp"
 #include "command_queue.hpp"
 #include "camera.hpp"
+#include "upload_buffer.hpp"
+#include "upload_ring.hpp"
+#include "transient_descriptor_allocator.hpp"
+#include "view_cache.hpp"
+#include "view_desc_keys.hpp"
+#include "command_recorder.hpp"
+#include "resource_state_tracker.hpp"
+#include "utility/thread_pool.hpp"
+#include "utility/log.hpp"
 
 #include "pipelines/geometry_pipeline.hpp"
 #include "pipelines/ui_pipeline.hpp"
+#include "pipelines/compute_pipeline.hpp"
 
 
-Renderer::Renderer(std::shared_ptr<Application> app) :
+Renderer::Renderer(std::shared_ptr<Application> app, uint32_t framesInFlight) :
 	_app(app),
     _width(_app->GetWidth()),
     _height(_app->GetHeight()),
 	_viewport(0.0f, 0.0f, static_cast<float>(_width), static_cast<float>(_height)),
 	_scissorRect(0, 0, static_cast<LONG>(_width), static_cast<LONG>(_height)),
+    _framesInFlight(framesInFlight),
     _useWarpDevice(false)
 {
+    assert(_framesInFlight > 0 && _framesInFlight <= MAX_FRAMES_IN_FLIGHT && "Invalid amount of frames in flight.");
+
     _aspectRatio = static_cast<float>(_width) / static_cast<float>(_height);
     _camera = std::make_shared<Camera>();
 
@@ -32,7 +47,8 @@ Renderer::Renderer(std::shared_ptr<Application> app) :
     InitializeCommandQueues();
     InitializeDescriptorHeaps();
     InitializeSwapchainResources();
-    CreateDepthTarget();
+    InitializeFrameContexts();
+    InitializeTransientResources();
     CreateBindlessRootSignature();
 
     // Create pipelines
@@ -42,9 +58,24 @@ Renderer::Renderer(std::shared_ptr<Application> app) :
 
 Renderer::~Renderer()
 {
+    // Pipelines hand their resources to the deferred release queues and the allocators,
+    // so they go first, while everything they release into is still around.
+    _uiPipeline.reset();
+    _geometryPipeline.reset();
+
     // Ensure that the GPU is no longer referencing resources that are about to be
     // cleaned up by the destructor.
     Flush();
+
+    _directCommandQueue->GetDeferredReleaseQueue().ReleaseAll();
+    _copyCommandQueue->GetDeferredReleaseQueue().ReleaseAll();
+    _computeCommandQueue->GetDeferredReleaseQueue().ReleaseAll();
+
+    for (const auto& renderTarget : _renderTargets)
+    {
+        ResourceStateTracker::RemoveGlobalResourceState(renderTarget.Get());
+    }
+    ResourceStateTracker::RemoveGlobalResourceState(_depthTarget.resource.Get());
 }
 
 void Renderer::Update(float deltaTime)
@@ -54,43 +85,269 @@ void Renderer::Update(float deltaTime)
 
 void Renderer::Render()
 {
-    auto commandList = _directCommandQueue->GetCommandList();
+    FrameContext& frame = GetCurrentFrame();
 
-    // Set heaps for bindless.
-    SetDescriptorHeaps(commandList);
+    // Everything marked as used has to be resident before the frame is submitted.
+    _residencyManager->Update();
+
+    // The cube's model matrix is built on the async compute queue, the direct queue
+    // only waits for it on the GPU before the geometry pass reads it.
+    JoinAsyncCompute(SubmitAsyncCompute([this](const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList) {
+        _geometryPipeline->PopulateComputeCommandlist(commandList);
+    }));
 
-    // Clear targets.
-    auto rtvHandle = _rtvHeap->GetDescriptorHandleFromIndex(_renderTargetIndex[_frameIndex]);
+    auto rtvHandle = _rtvHeap->GetDescriptorHandleFromIndex(_renderTargetIndex[_backBufferIndex]);
     auto dsvHandle = _dsvHeap->GetDescriptorHandleFromIndex(_depthTargetIndex);
-    Util::TransitionResource(commandList, _renderTargets[_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-    commandList->ClearRenderTargetView(rtvHandle.cpuDescriptorHandle, clearColor, 0, nullptr);
-    commandList->ClearDepthStencilView(dsvHandle.cpuDescriptorHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    ID3D12Resource* renderTarget = _renderTargets[_backBufferIndex].Get();
+
+    // Every command list starts out without any state, so each one binds heaps and targets itself.
+    auto bindRenderTargets = [this, rtvHandle, dsvHandle](const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList) {
+        SetDescriptorHeaps(commandList);
+        commandList->OMSetRenderTargets(1, &rtvHandle.cpuDescriptorHandle, FALSE, &dsvHandle.cpuDescriptorHandle);
+        commandList->RSSetViewports(1, &_viewport);
+        commandList->RSSetScissorRects(1, &_scissorRect);
+    };
 
-    // Record command lists.
-    commandList->OMSetRenderTargets(1, &rtvHandle.cpuDescriptorHandle, FALSE, &dsvHandle.cpuDescriptorHandle);
-    commandList->RSSetViewports(1, &_viewport);
-    commandList->RSSetScissorRects(1, &_scissorRect);
-    _geometryPipeline->PopulateCommandlist(commandList);
+    // Declare this frame's passes, the graph takes care of the barriers in between.
+    _renderGraph->Reset();
+    const auto backBuffer = _renderGraph->ImportResource("Back Buffer", renderTarget,
+        ResourceState::Present, ResourceState::Present);
+    const auto depthTarget = _renderGraph->CreateTransientResource("Depth Target", _depthTarget.allocationInfo.SizeInBytes,
+        _depthTarget.allocationInfo.Alignment, ResourceState::DepthWrite);
+
+    const uint32_t clearPass = _renderGraph->AddPass("Clear", [&](RenderPassContext& context) {
+        context.commandList->ClearRenderTargetView(rtvHandle.cpuDescriptorHandle, clearColor, 0, nullptr);
+        context.commandList->ClearDepthStencilView(dsvHandle.cpuDescriptorHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    });
+    _renderGraph->Write(clearPass, backBuffer, ResourceState::RenderTarget, ResourceAccess::Write);
+    _renderGraph->Write(clearPass, depthTarget, ResourceState::DepthWrite, ResourceAccess::Write);
+
+    const uint32_t geometryPass = _renderGraph->AddPass("Geometry", [&](RenderPassContext& context) {
+        bindRenderTargets(context.commandList);
+        _geometryPipeline->PopulateCommandlist(context.commandList);
+    });
+    _renderGraph->Write(geometryPass, backBuffer, ResourceState::RenderTarget);
+    _renderGraph->Write(geometryPass, depthTarget, ResourceState::DepthWrite);
+
+    const uint32_t uiPass = _renderGraph->AddPass("UI", [&](RenderPassContext& context) {
+        bindRenderTargets(context.commandList);
+        _uiPipeline->PopulateCommandlist(context.commandList);
+    });
+    _renderGraph->Write(uiPass, backBuffer, ResourceState::RenderTarget);
+
+    if (_renderGraph->Compile())
+    {
+        PlaceTransientResources(depthTarget);
+    }
+    _renderGraph->SetNativeResource(depthTarget, _depthTarget.resource.Get());
+    RecordRenderGraph();
 
-    // Sync up resource(s) (might need this in between some stages later)
-    Util::TransitionResource(commandList, _renderTargets[_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+    // Record in parallel and execute all command lists at once.
+    frame.fenceValue = _commandRecorder->Submit();
 
-    // Execute commandlist.
-    uint64_t fenceValue = _directCommandQueue->ExecuteCommandList(commandList);
-    _fenceValues[_frameIndex] = fenceValue;
+    // Everything released while the frame was recorded lives until the frame is done with it.
+    _directCommandQueue->GetDeferredReleaseQueue().RetireUnsubmitted(frame.fenceValue);
 
     // Present the frame.
     Util::ThrowIfFailed(_swapChain->Present(1, 0));
+    _backBufferIndex = _swapChain->GetCurrentBackBufferIndex();
+
+    // Move on to the next frame context, this only blocks when the GPU is
+    // more than _framesInFlight frames behind.
+    _frameIndex = (_frameIndex + 1) % _framesInFlight;
+    BeginFrame();
+}
+
+// Every pass that survived compilation is recorded into its own command list,
+// starting with the batch of barriers the graph generated for it.
+// The barriers go through the list's state tracker, so transitions that turn out to be
+// redundant are dropped and the state before the first one is resolved on submission.
+void Renderer::RecordRenderGraph()
+{
+    const auto& compiledPasses = _renderGraph->GetCompiledPasses();
+    for (size_t i = 0; i < compiledPasses.size(); ++i)
+    {
+        const bool isLastPass = i + 1 == compiledPasses.size();
+        _commandRecorder->AddTask([this, &compiledPass = compiledPasses[i], isLastPass](const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList, ResourceStateTracker& tracker) {
+            RecordBarriers(tracker, compiledPass.barriers);
+            tracker.FlushResourceBarriers(commandList);
+
+            RenderPassContext context{ commandList };
+            _renderGraph->GetExecuteFunction(compiledPass.passIndex)(context);
+
+            if (isLastPass)
+            {
+                RecordBarriers(tracker, _renderGraph->GetFinalBarriers());
+            }
+        });
+    }
+
+    if (compiledPasses.empty() && !_renderGraph->GetFinalBarriers().empty())
+    {
+        _commandRecorder->AddTask([this](const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>&, ResourceStateTracker& tracker) {
+            RecordBarriers(tracker, _renderGraph->GetFinalBarriers());
+        });
+    }
+}
+
+void Renderer::RecordBarriers(ResourceStateTracker& tracker, const std::vector<RenderGraph::Barrier>& barriers) const
+{
+    static_assert(static_cast<uint32_t>(ResourceState::RenderTarget) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+    static_assert(static_cast<uint32_t>(ResourceState::UnorderedAccess) == D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    static_assert(static_cast<uint32_t>(ResourceState::DepthWrite) == D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    static_assert(static_cast<uint32_t>(ResourceState::DepthRead) == D3D12_RESOURCE_STATE_DEPTH_READ);
+    static_assert(static_cast<uint32_t>(ResourceState::NonPixelShaderResource) == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    static_assert(static_cast<uint32_t>(ResourceState::PixelShaderResource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    static_assert(static_cast<uint32_t>(ResourceState::CopyDest) == D3D12_RESOURCE_STATE_COPY_DEST);
+    static_assert(static_cast<uint32_t>(ResourceState::CopySource) == D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    for (const auto& barrier : barriers)
+    {
+        ID3D12Resource* resource = static_cast<ID3D12Resource*>(_renderGraph->GetNativeResource(barrier.resource));
+        if (barrier.isAliasingBarrier)
+        {
+            ID3D12Resource* resourceBefore = barrier.aliasedResource != RenderGraph::InvalidResource ?
+                static_cast<ID3D12Resource*>(_renderGraph->GetNativeResource(barrier.aliasedResource)) : nullptr;
+            tracker.AliasBarrier(resourceBefore, resource);
+        }
+        else if (barrier.isUavBarrier)
+        {
+            tracker.UAVBarrier(resource);
+        }
+        else
+        {
+            tracker.TransitionResource(resource, static_cast<D3D12_RESOURCE_STATES>(barrier.after));
+        }
+    }
+}
+
+void Renderer::BeginFrame()
+{
+    FrameContext& frame = GetCurrentFrame();
+    _directCommandQueue->WaitForFenceValue(frame.fenceValue);
+    _computeCommandQueue->WaitForFenceValue(frame.computeFenceValue);
+
+    // The GPU is done with everything this frame context handed out.
+    frame.constantRing->Reset();
+    frame.uploadRing->Reset();
+    frame.transientDescriptors->Reset();
+
+    _directCommandQueue->GetDeferredReleaseQueue().ReleaseCompleted();
+    _copyCommandQueue->GetDeferredReleaseQueue().ReleaseCompleted();
+    _computeCommandQueue->GetDeferredReleaseQueue().ReleaseCompleted();
+}
+
+void Renderer::DeferRelease(Microsoft::WRL::ComPtr<ID3D12Resource> resource)
+{
+    // The tracked state goes away together with the resource, not before frames in flight are done with it.
+    _directCommandQueue->GetDeferredReleaseQueue().RetireOnSubmit([resource = std::move(resource)]() mutable {
+        ResourceStateTracker::RemoveGlobalResourceState(resource.Get());
+        resource.Reset();
+    });
+}
+
+void Renderer::DeferRelease(Microsoft::WRL::ComPtr<ID3D12Resource> resource, const GpuAllocation& memory)
+{
+    _directCommandQueue->GetDeferredReleaseQueue().RetireOnSubmit([this, resource = std::move(resource), memory]() mutable {
+        ResourceStateTracker::RemoveGlobalResourceState(resource.Get());
+        resource.Reset();
+        _memoryAllocator->Free(memory);
+    });
+}
+
+void Renderer::TrackResidency(ID3D12Resource* resource, const GpuAllocation& memory)
+{
+    if (ID3D12Heap* heap = _memoryAllocator->GetHeap(memory))
+    {
+        _residencyManager->Track(heap, _memoryAllocator->GetBlockSize());
+    }
+    else
+    {
+        const D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+        _residencyManager->Track(resource, _device->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes);
+    }
+}
+
+void Renderer::UntrackResidency(ID3D12Resource* resource, const GpuAllocation& memory)
+{
+    ID3D12Heap* heap = _memoryAllocator->GetHeap(memory);
+    _residencyManager->Untrack(heap ? static_cast<ID3D12Pageable*>(heap) : resource);
+}
+
+void Renderer::MarkUsed(ID3D12Resource* resource, const GpuAllocation& memory)
+{
+    ID3D12Heap* heap = _memoryAllocator->GetHeap(memory);
+    _residencyManager->MarkUsed(heap ? static_cast<ID3D12Pageable*>(heap) : resource);
+}
+
+void Renderer::ReleaseDescriptor(const DescriptorAllocation& allocation)
+{
+    if (!_viewCache->Release(allocation))
+    {
+        return;
+    }
+
+    _directCommandQueue->GetDeferredReleaseQueue().RetireOnSubmit([this, allocation]() {
+        _srvHeap->Free(allocation);
+    });
+}
+
+void Renderer::ReleaseSampler(const DescriptorAllocation& allocation)
+{
+    if (!_samplerCache->Release(allocation))
+    {
+        return;
+    }
 
-    // Wait for new back buffer to be done.
-    _frameIndex = _swapChain->GetCurrentBackBufferIndex();
-    _directCommandQueue->WaitForFenceValue(_fenceValues[_frameIndex]);
+    _directCommandQueue->GetDeferredReleaseQueue().RetireOnSubmit([this, allocation]() {
+        _samplerHeap->Free(allocation);
+    });
+}
+
+void Renderer::SetFramesInFlight(uint32_t framesInFlight)
+{
+    assert(framesInFlight > 0 && framesInFlight <= MAX_FRAMES_IN_FLIGHT && "Invalid amount of frames in flight.");
+    if (framesInFlight == _framesInFlight)
+    {
+        return;
+    }
+
+    // Frame contexts might still be referenced by the GPU.
+    Flush();
+
+    _framesInFlight = framesInFlight;
+    InitializeFrameContexts();
 }
 
 void Renderer::Flush()
 {
     _directCommandQueue->Flush();
     _copyCommandQueue->Flush();
+    _computeCommandQueue->Flush();
+}
+
+uint64_t Renderer::SubmitAsyncCompute(const std::function<void(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>&)>& record)
+{
+    auto commandList = _computeCommandQueue->GetCommandList();
+    SetDescriptorHeaps(commandList);
+
+    record(commandList);
+
+    // Views created so far, including the ones record() created, become visible to shaders.
+    _srvHeap->FlushStagedDescriptors();
+
+    // Frame rings handed out to the compute work have to stay alive until the compute queue is done too.
+    // Several submissions can share a frame, the frame has to wait for the last one.
+    FrameContext& frame = GetCurrentFrame();
+    const uint64_t fenceValue = _computeCommandQueue->ExecuteCommandList(commandList);
+    frame.computeFenceValue = (std::max)(frame.computeFenceValue, fenceValue);
+
+    return fenceValue;
+}
+
+void Renderer::JoinAsyncCompute(uint64_t computeFenceValue)
+{
+    _directCommandQueue->InsertWait(*_computeCommandQueue, computeFenceValue);
 }
 
 void Renderer::SetDescriptorHeaps(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList) const
@@ -155,21 +412,41 @@ void Renderer::InitializeCore()
 
     Util::CheckFeatureSupport(_device);
 
+    _memoryAllocator = std::make_unique<GpuMemoryAllocator>(_device);
+
 }
 
 void Renderer::InitializeCommandQueues()
 {
     _directCommandQueue = std::make_unique<CommandQueue>(_device, D3D12_COMMAND_LIST_TYPE_DIRECT);
     _copyCommandQueue = std::make_unique<CommandQueue>(_device, D3D12_COMMAND_LIST_TYPE_COPY);
+    _computeCommandQueue = std::make_unique<CommandQueue>(_device, D3D12_COMMAND_LIST_TYPE_COMPUTE);
+    _uploadRing = std::make_unique<UploadRing>(_device, *_copyCommandQueue, UPLOAD_RING_SIZE, L"Upload Ring");
+
+    _threadPool = std::make_unique<Util::ThreadPool>();
+
+    // Residency is tracked in direct queue fence values, that's where resources are used.
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter;
+    Util::ThrowIfFailed(_factory->EnumAdapterByLuid(_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)));
+    _residencyManager = std::make_unique<ResidencyManager>(_device, adapter, *_directCommandQueue);
+    _renderGraph = std::make_unique<RenderGraph>();
 }
 
 void Renderer::InitializeDescriptorHeaps()
 {
     _rtvHeap = std::make_unique<DescriptorHeap>(_device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, FRAME_COUNT, L"Render Target View");
     _dsvHeap = std::make_unique<DescriptorHeap>(_device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, L"Depth Stencil View");
-    _srvHeap = std::make_unique<DescriptorHeap>(_device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, MAX_CBV_SRV_UAV_COUNT, L"Shader Resource View");
+    // The bindless heap is as large as the device allows, views are created in its staging heap.
+    _srvHeap = std::make_unique<DescriptorHeap>(_device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+                                                Util::GetMaxShaderVisibleDescriptorCount(_device), L"Shader Resource View",
+                                                CBV_SRV_UAV_STAGING_COUNT);
+    _transientDescriptorRange = _srvHeap->Allocate(TRANSIENT_DESCRIPTOR_COUNT);
+    _viewCache = std::make_unique<ViewCache>();
+    // Passes are recorded into lists that index the bindless heap.
+    _commandRecorder = std::make_unique<CommandRecorder>(*_directCommandQueue, *_threadPool, *_srvHeap);
     _samplerHeap = std::make_unique<DescriptorHeap>(_device, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
                                                                D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE, L"Sampler Descriptor Heap");
+    _samplerCache = std::make_unique<ViewCache>();
 }
 
 void Renderer::InitializeSwapchainResources()
@@ -202,11 +479,30 @@ void Renderer::InitializeSwapchainResources()
     Util::ThrowIfFailed(_factory->MakeWindowAssociation(_app->GetHWND(), DXGI_MWA_NO_ALT_ENTER));
 
     Util::ThrowIfFailed(swapChain.As(&_swapChain));
-    _frameIndex = _swapChain->GetCurrentBackBufferIndex();
+    _backBufferIndex = _swapChain->GetCurrentBackBufferIndex();
 
     CreateRenderTargets();
 }
 
+void Renderer::InitializeFrameContexts()
+{
+    _frames.clear();
+    _frames.resize(_framesInFlight);
+    _frameIndex = 0;
+
+    const uint32_t transientDescriptorCount = _transientDescriptorRange.count / _framesInFlight;
+
+    for (uint32_t n = 0; n < _framesInFlight; n++)
+    {
+        _frames[n].constantRing = std::make_unique<UploadBuffer>(_device, FRAME_CONSTANT_RING_SIZE,
+            std::wstring(L"Frame Constant Ring ") + std::to_wstring(n));
+        _frames[n].uploadRing = std::make_unique<UploadBuffer>(_device, FRAME_UPLOAD_RING_SIZE,
+            std::wstring(L"Frame Upload Ring ") + std::to_wstring(n));
+        _frames[n].transientDescriptors = std::make_unique<TransientDescriptorAllocator>(
+            _transientDescriptorRange.index + n * transientDescriptorCount, transientDescriptorCount);
+    }
+}
+
 void Renderer::CreateRenderTargets()
 {
     // Create a RTV for each frame.
@@ -217,32 +513,55 @@ void Renderer::CreateRenderTargets()
             .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
             .ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D,
         };
-        _renderTargetIndex[n] = CreateRtv(desc, _renderTargets[n]);
+        _renderTargetIndex[n] = CreateRtv(desc, _renderTargets[n]).index;
         std::wstring name = std::wstring(L"Render Target ") + std::to_wstring(n);
         _renderTargets[n]->SetName(name.c_str());
+
+        ResourceStateTracker::AddGlobalResourceState(_renderTargets[n].Get(), D3D12_RESOURCE_STATE_PRESENT);
     }
 }
 
-void Renderer::CreateDepthTarget()
+void Renderer::InitializeTransientResources()
 {
-    // Flush any GPU commands that might be referencing the depth buffer.
-    Flush();
+    _depthTarget.desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, _width, _height,
+        1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+    _depthTarget.clearValue.Format = DXGI_FORMAT_D32_FLOAT;
+    _depthTarget.clearValue.DepthStencil = { 1.0f, 0 };
+    _depthTarget.allocationInfo = _device->GetResourceAllocationInfo(0, 1, &_depthTarget.desc);
 
-    D3D12_CLEAR_VALUE optimizedClearValue = {};
-    optimizedClearValue.Format = DXGI_FORMAT_D32_FLOAT;
-    optimizedClearValue.DepthStencil = { 1.0f, 0 };
+    // The view is written once the depth target is placed.
+    _depthTargetIndex = _dsvHeap->Allocate().index;
+}
 
-    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
-    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, _width, _height,
-        1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-    Util::ThrowIfFailed(_device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &resourceDesc,
-        D3D12_RESOURCE_STATE_DEPTH_WRITE,
-        &optimizedClearValue,
-        IID_PPV_ARGS(&_depthTarget)
-    ));
+// Runs whenever the render graph compiled a new plan. The transient resources move into a new heap of the
+// planned size, frames in flight keep using the old one until they're done with it.
+void Renderer::PlaceTransientResources(RenderGraph::ResourceHandle depthTarget)
+{
+    if (_depthTarget.resource)
+    {
+        DeferRelease(std::move(_depthTarget.resource));
+    }
+    if (_transientHeap)
+    {
+        _directCommandQueue->GetDeferredReleaseQueue().RetireOnSubmit(std::move(_transientHeap));
+    }
+
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = _renderGraph->GetTransientHeapSize();
+    heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    heapDesc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    Util::ThrowIfFailed(_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&_transientHeap)));
+    _transientHeap->SetName(L"Transient Heap");
+
+    const uint64_t depthTargetOffset = _renderGraph->GetTransientOffset(depthTarget);
+    assert(depthTargetOffset != RenderGraph::InvalidOffset && "No pass uses the depth target.");
+
+    // Placed render targets start out undefined, the clear pass initializes the depth target every frame.
+    Util::ThrowIfFailed(_device->CreatePlacedResource(_transientHeap.Get(), depthTargetOffset, &_depthTarget.desc,
+        D3D12_RESOURCE_STATE_DEPTH_WRITE, &_depthTarget.clearValue, IID_PPV_ARGS(&_depthTarget.resource)));
+    _depthTarget.resource->SetName(L"Depth Target");
+    ResourceStateTracker::AddGlobalResourceState(_depthTarget.resource.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
     const D3D12_DEPTH_STENCIL_VIEW_DESC dsv = {
         .Format = DXGI_FORMAT_D32_FLOAT,
@@ -253,8 +572,12 @@ void Renderer::CreateDepthTarget()
         }
     };
 
-    _depthTargetIndex = CreateDsv(dsv, _depthTarget);
-    _depthTarget->SetName(L"Depth Target");
+    // DSVs are consumed when recorded, so the slot can be overwritten right away.
+    _device->CreateDepthStencilView(_depthTarget.resource.Get(), &dsv,
+                                     _dsvHeap->GetDescriptorHandleFromIndex(_depthTargetIndex).cpuDescriptorHandle);
+
+    dblog::info("[RENDER GRAPH] Transient heap of {} KiB, {} KiB without aliasing.",
+        _renderGraph->GetTransientHeapSize() / 1024, _renderGraph->GetUnaliasedTransientSize() / 1024);
 }
 
 void Renderer::CreateBindlessRootSignature()
@@ -265,7 +588,7 @@ void Renderer::CreateBindlessRootSignature()
         D3D12_ROOT_SIGNATURE_FLAG_SAMPLER_HEAP_DIRECTLY_INDEXED;
 
     CD3DX12_ROOT_PARAMETER rootParameters[1];
-    rootParameters[0].InitAsConstants(64, 0, 0, D3D12_SHADER_VISIBILITY_ALL);
+    rootParameters[0].InitAsConstants(ROOT_CONSTANT_COUNT, 0, 0, D3D12_SHADER_VISIBILITY_ALL);
 
     CD3DX12_STATIC_SAMPLER_DESC defaultSampler;
     defaultSampler.Init(0);
@@ -280,63 +603,190 @@ void Renderer::CreateBindlessRootSignature()
 }
 
 
-uint32_t Renderer::CreateCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc) const
+DescriptorAllocation Renderer::CreateCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc) const
 {
-    const uint32_t cbvIndex = _srvHeap->GetCurrentDescriptorIndex();
+    if (const DescriptorAllocation existingCbv = _viewCache->Acquire(ViewType::Cbv, nullptr, cbvCreationDesc); !existingCbv.IsNull())
+    {
+        return existingCbv;
+    }
+
+    const DescriptorAllocation cbv = _srvHeap->Allocate();
 
     _device->CreateConstantBufferView(&cbvCreationDesc,
-                                       _srvHeap->GetCurrentDescriptorHandle().cpuDescriptorHandle);
+                                       _srvHeap->GetStagingDescriptorHandle(cbv));
+    _srvHeap->StageDescriptors(cbv);
 
-    _srvHeap->OffsetCurrentHandle();
+    // Another thread might have created the same view in the meantime.
+    const DescriptorAllocation cachedCbv = _viewCache->Add(ViewType::Cbv, nullptr, cbvCreationDesc, cbv);
+    if (cachedCbv.index != cbv.index)
+    {
+        _srvHeap->Free(cbv);
+    }
 
-    return cbvIndex;
+    return cachedCbv;
 }
 
-uint32_t Renderer::CreateSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
+DescriptorAllocation Renderer::CreateSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
 {
-    const uint32_t srvIndex = _srvHeap->GetCurrentDescriptorIndex();
+    if (const DescriptorAllocation existingSrv = _viewCache->Acquire(ViewType::Srv, resource.Get(), srvCreationDesc); !existingSrv.IsNull())
+    {
+        return existingSrv;
+    }
+
+    const DescriptorAllocation srv = _srvHeap->Allocate();
 
     _device->CreateShaderResourceView(resource.Get(), &srvCreationDesc,
-                                       _srvHeap->GetCurrentDescriptorHandle().cpuDescriptorHandle);
+                                       _srvHeap->GetStagingDescriptorHandle(srv));
+    _srvHeap->StageDescriptors(srv);
 
-    _srvHeap->OffsetCurrentHandle();
+    // Another thread might have created the same view in the meantime.
+    const DescriptorAllocation cachedSrv = _viewCache->Add(ViewType::Srv, resource.Get(), srvCreationDesc, srv);
+    if (cachedSrv.index != srv.index)
+    {
+        _srvHeap->Free(srv);
+    }
 
-    return srvIndex;
+    return cachedSrv;
 }
 
-uint32_t Renderer::CreateUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
+DescriptorAllocation Renderer::CreateUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
 {
-    const uint32_t uavIndex = _srvHeap->GetCurrentDescriptorIndex();
+    if (const DescriptorAllocation existingUav = _viewCache->Acquire(ViewType::Uav, resource.Get(), uavCreationDesc); !existingUav.IsNull())
+    {
+        return existingUav;
+    }
+
+    const DescriptorAllocation uav = _srvHeap->Allocate();
 
     _device->CreateUnorderedAccessView(
         resource.Get(), nullptr, &uavCreationDesc,
-        _srvHeap->GetCurrentDescriptorHandle().cpuDescriptorHandle);
+        _srvHeap->GetStagingDescriptorHandle(uav));
+    _srvHeap->StageDescriptors(uav);
 
-    _srvHeap->OffsetCurrentHandle();
+    // Another thread might have created the same view in the meantime.
+    const DescriptorAllocation cachedUav = _viewCache->Add(ViewType::Uav, resource.Get(), uavCreationDesc, uav);
+    if (cachedUav.index != uav.index)
+    {
+        _srvHeap->Free(uav);
+    }
 
-    return uavIndex;
+    return cachedUav;
 }
 
-uint32_t Renderer::CreateRtv(const D3D12_RENDER_TARGET_VIEW_DESC& rtvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
+DescriptorAllocation Renderer::CreateRtv(const D3D12_RENDER_TARGET_VIEW_DESC& rtvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
 {
-    const uint32_t rtvIndex = _rtvHeap->GetCurrentDescriptorIndex();
+    const DescriptorAllocation rtv = _rtvHeap->Allocate();
 
     _device->CreateRenderTargetView(resource.Get(), &rtvCreationDesc,
-                                     _rtvHeap->GetCurrentDescriptorHandle().cpuDescriptorHandle);
+                                     _rtvHeap->GetDescriptorHandle(rtv).cpuDescriptorHandle);
 
-    _rtvHeap->OffsetCurrentHandle();
-
-    return rtvIndex;
+    return rtv;
 }
 
-uint32_t Renderer::CreateDsv(const D3D12_DEPTH_STENCIL_VIEW_DESC& dsvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
+DescriptorAllocation Renderer::CreateDsv(const D3D12_DEPTH_STENCIL_VIEW_DESC& dsvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource) const
 {
-    const uint32_t dsvIndex = _dsvHeap->GetCurrentDescriptorIndex();
+    const DescriptorAllocation dsv = _dsvHeap->Allocate();
 
     _device->CreateDepthStencilView(resource.Get(), &dsvCreationDesc,
-                                     _dsvHeap->GetCurrentDescriptorHandle().cpuDescriptorHandle);
+                                     _dsvHeap->GetDescriptorHandle(dsv).cpuDescriptorHandle);
 
-    _dsvHeap->OffsetCurrentHandle();
+    return dsv;
+}
 
-    return dsvIndex;
+DescriptorAllocation Renderer::CreateSampler(const D3D12_SAMPLER_DESC& samplerCreationDesc) const
+{
+    if (const DescriptorAllocation existingSampler = _samplerCache->Acquire(ViewType::Sampler, nullptr, samplerCreationDesc); !existingSampler.IsNull())
+    {
+        return existingSampler;
+    }
+
+    const DescriptorAllocation sampler = _samplerHeap->Allocate();
+
+    _device->CreateSampler(&samplerCreationDesc, _samplerHeap->GetDescriptorHandle(sampler).cpuDescriptorHandle);
+
+    // Another thread might have created the same sampler in the meantime.
+    const DescriptorAllocation cachedSampler = _samplerCache->Add(ViewType::Sampler, nullptr, samplerCreationDesc, sampler);
+    if (cachedSampler.index != sampler.index)
+    {
+        _samplerHeap->Free(sampler);
+    }
+
+    return cachedSampler;
+}
+
+uint32_t Renderer::CreateTransientCbv(const D3D12_CONSTANT_BUFFER_VIEW_DESC& cbvCreationDesc)
+{
+    const uint32_t cbvIndex = GetCurrentFrame().transientDescriptors->Allocate();
+
+    _device->CreateConstantBufferView(&cbvCreationDesc,
+                                       _srvHeap->GetDescriptorHandleFromIndex(cbvIndex).cpuDescriptorHandle);
+
+    return cbvIndex;
+}
+
+uint32_t Renderer::CreateTransientSrv(const D3D12_SHADER_RESOURCE_VIEW_DESC& srvCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource)
+{
+    const uint32_t srvIndex = GetCurrentFrame().transientDescriptors->Allocate();
+
+    _device->CreateShaderResourceView(resource.Get(), &srvCreationDesc,
+                                       _srvHeap->GetDescriptorHandleFromIndex(srvIndex).cpuDescriptorHandle);
+
+    return srvIndex;
+}
+
+uint32_t Renderer::CreateTransientStructuredBuffer(const void* elements, uint32_t elementCount, uint32_t elementStride)
+{
+    assert(elementStride > 0 && elementStride % sizeof(uint32_t) == 0 && "Structured buffer strides are a multiple of 4 bytes.");
+
+    // The view has to start at a whole element. Power of two strides get there through the alignment,
+    // other strides get room to round the start up to the next element.
+    const uint64_t dataSize = static_cast<uint64_t>(elementCount) * elementStride;
+    const bool isPowerOfTwoStride = (elementStride & (elementStride - 1)) == 0;
+    const UploadBuffer::Allocation allocation = GetCurrentFrame().uploadRing->Allocate(
+        isPowerOfTwoStride ? dataSize : dataSize + elementStride - sizeof(uint32_t),
+        isPowerOfTwoStride ? elementStride : sizeof(uint32_t));
+    const uint64_t firstElement = (allocation.offset + elementStride - 1) / elementStride;
+    const uint64_t padding = firstElement * elementStride - allocation.offset;
+    memcpy(static_cast<uint8_t*>(allocation.cpuAddress) + padding, elements, static_cast<size_t>(dataSize));
+
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+        .Buffer = {
+            .FirstElement = firstElement,
+            .NumElements = elementCount,
+            .StructureByteStride = elementStride,
+          },
+    };
+
+    const uint32_t srvIndex = GetCurrentFrame().transientDescriptors->Allocate();
+    _device->CreateShaderResourceView(allocation.resource, &srvDesc,
+                                       _srvHeap->GetDescriptorHandleFromIndex(srvIndex).cpuDescriptorHandle);
+
+    return srvIndex;
+}
+
+DynamicConstantBuffer Renderer::AllocateConstants(const void* constants, uint32_t size)
+{
+    const uint32_t alignedSize = (size + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) &
+        ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+    const UploadBuffer::Allocation allocation = GetCurrentFrame().constantRing->Allocate(alignedSize);
+    memcpy(allocation.cpuAddress, constants, size);
+
+    return DynamicConstantBuffer{
+        .gpuAddress = allocation.gpuAddress,
+        .cbvIndex = CreateTransientCbv({ .BufferLocation = allocation.gpuAddress, .SizeInBytes = alignedSize }),
+    };
+}
+
+uint32_t Renderer::CreateTransientUav(const D3D12_UNORDERED_ACCESS_VIEW_DESC& uavCreationDesc, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource)
+{
+    const uint32_t uavIndex = GetCurrentFrame().transientDescriptors->Allocate();
+
+    _device->CreateUnorderedAccessView(
+        resource.Get(), nullptr, &uavCreationDesc,
+        _srvHeap->GetDescriptorHandleFromIndex(uavIndex).cpuDescriptorHandle);
+
+    return uavIndex;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "residency_manager.hpp"
+
+#include "command_queue.hpp"
+#include "utility/dx12_helpers.hpp"
+#include "utility/log.hpp"
+
+ResidencyManager::ResidencyManager(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const Microsoft::WRL::ComPtr<IDXGIAdapter3>& adapter,
+    CommandQueue& queue)
+    : _device(device)
+    , _adapter(adapter)
+    , _queue(queue)
+{
+}
+
+void ResidencyManager::Track(ID3D12Pageable* pageable, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (const auto it = _objects.find(pageable); it != _objects.end())
+    {
+        ++it->second.referenceCount;
+        return;
+    }
+
+    const uint32_t handle = _tracker.Add(size, _queue.GetNextFenceValue());
+    if (handle >= _pageables.size())
+    {
+        _pageables.resize(handle + 1);
+    }
+    _pageables[handle] = pageable;
+    _objects.emplace(pageable, TrackedObject{ handle, 1u });
+}
+
+void ResidencyManager::Untrack(ID3D12Pageable* pageable)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto it = _objects.find(pageable);
+    assert(it != _objects.end() && "Object isn't tracked.");
+
+    if (--it->second.referenceCount > 0)
+    {
+        return;
+    }
+
+    _tracker.Remove(it->second.handle);
+    _pageables[it->second.handle] = nullptr;
+    _objects.erase(it);
+}
+
+void ResidencyManager::MarkUsed(ID3D12Pageable* pageable)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto it = _objects.find(pageable);
+    assert(it != _objects.end() && "Object isn't tracked.");
+
+    _tracker.MarkUsed(it->second.handle, _queue.GetNextFenceValue());
+}
+
+void ResidencyManager::Update()
+{
+    const DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = GetVideoMemoryInfo();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // The OS reports usage of the whole process, only the tracked part can be evicted.
+    const uint64_t untrackedUsage = memoryInfo.CurrentUsage - (std::min)(memoryInfo.CurrentUsage, _tracker.GetResidentSize());
+    const uint64_t budget = memoryInfo.Budget - (std::min)(memoryInfo.Budget, untrackedUsage);
+
+    const ResidencyTracker::Changes changes = _tracker.Update(budget, _queue.GetFence()->GetCompletedValue());
+
+    // MakeResident blocks until the memory is available again, so do it for everything at once.
+    if (!changes.makeResident.empty())
+    {
+        _batch.clear();
+        for (const uint32_t handle : changes.makeResident)
+        {
+            _batch.push_back(_pageables[handle]);
+        }
+        Util::ThrowIfFailed(_device->MakeResident(static_cast<UINT>(_batch.size()), _batch.data()));
+    }
+
+    if (!changes.evict.empty())
+    {
+        _batch.clear();
+        for (const uint32_t handle : changes.evict)
+        {
+            _batch.push_back(_pageables[handle]);
+        }
+        Util::ThrowIfFailed(_device->Evict(static_cast<UINT>(_batch.size()), _batch.data()));
+
+        dblog::info("[RESIDENCY] Evicted {} objects, budget {} MiB, usage {} MiB.", changes.evict.size(),
+            memoryInfo.Budget / (1024 * 1024), memoryInfo.CurrentUsage / (1024 * 1024));
+    }
+}
+
+DXGI_QUERY_VIDEO_MEMORY_INFO ResidencyManager::GetVideoMemoryInfo() const
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    Util::ThrowIfFailed(_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo));
+    return memoryInfo;
+}
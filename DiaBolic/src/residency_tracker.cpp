@@ -0,0 +1,155 @@
+#include "residency_tracker.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+uint32_t ResidencyTracker::Add(uint64_t size, uint64_t fenceValue)
+{
+    uint32_t handle;
+    if (!_unusedHandles.empty())
+    {
+        handle = _unusedHandles.back();
+        _unusedHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(_entries.size());
+        _entries.emplace_back();
+    }
+
+    _entries[handle] = Entry{ .size = size, .lastUsedFenceValue = fenceValue, .isResident = true, .isTracked = true };
+    LinkNewest(handle);
+
+    _residentSize += size;
+    _trackedSize += size;
+    return handle;
+}
+
+void ResidencyTracker::Remove(uint32_t handle)
+{
+    Entry& entry = _entries[handle];
+    assert(entry.isTracked && "Object isn't tracked.");
+
+    if (entry.isPendingResident)
+    {
+        _pendingResident.erase(std::find(_pendingResident.begin(), _pendingResident.end(), handle));
+    }
+    else if (entry.isResident)
+    {
+        Unlink(handle);
+    }
+
+    if (entry.isResident)
+    {
+        _residentSize -= entry.size;
+    }
+    _trackedSize -= entry.size;
+
+    entry = Entry{};
+    _unusedHandles.push_back(handle);
+}
+
+void ResidencyTracker::MarkUsed(uint32_t handle, uint64_t fenceValue)
+{
+    Entry& entry = _entries[handle];
+    assert(entry.isTracked && "Object isn't tracked.");
+
+    entry.lastUsedFenceValue = (std::max)(entry.lastUsedFenceValue, fenceValue);
+
+    if (entry.isPendingResident)
+    {
+        return;
+    }
+
+    if (entry.isResident)
+    {
+        // Move it to the most recently used end.
+        Unlink(handle);
+        LinkNewest(handle);
+        return;
+    }
+
+    entry.isResident = true;
+    entry.isPendingResident = true;
+    _residentSize += entry.size;
+    _pendingResident.push_back(handle);
+}
+
+ResidencyTracker::Changes ResidencyTracker::Update(uint64_t budget, uint64_t completedFenceValue)
+{
+    Changes changes;
+
+    // Pending objects were used most recently, so they go in front of the list.
+    changes.makeResident = std::move(_pendingResident);
+    _pendingResident.clear();
+    for (const uint32_t handle : changes.makeResident)
+    {
+        _entries[handle].isPendingResident = false;
+        LinkNewest(handle);
+    }
+
+    uint32_t handle = _oldest;
+    while (_residentSize > budget && handle != InvalidHandle)
+    {
+        Entry& entry = _entries[handle];
+        const uint32_t newer = entry.newer;
+        if (entry.lastUsedFenceValue > completedFenceValue)
+        {
+            // The GPU might still access it.
+            handle = newer;
+            continue;
+        }
+
+        Unlink(handle);
+        entry.isResident = false;
+        _residentSize -= entry.size;
+        changes.evict.push_back(handle);
+
+        handle = newer;
+    }
+
+    return changes;
+}
+
+void ResidencyTracker::LinkNewest(uint32_t handle)
+{
+    Entry& entry = _entries[handle];
+    entry.newer = InvalidHandle;
+    entry.older = _newest;
+
+    if (_newest != InvalidHandle)
+    {
+        _entries[_newest].newer = handle;
+    }
+    else
+    {
+        _oldest = handle;
+    }
+    _newest = handle;
+}
+
+void ResidencyTracker::Unlink(uint32_t handle)
+{
+    Entry& entry = _entries[handle];
+
+    if (entry.newer != InvalidHandle)
+    {
+        _entries[entry.newer].older = entry.older;
+    }
+    else
+    {
+        _newest = entry.older;
+    }
+
+    if (entry.older != InvalidHandle)
+    {
+        _entries[entry.older].newer = entry.newer;
+    }
+    else
+    {
+        _oldest = entry.newer;
+    }
+
+    entry.newer = InvalidHandle;
+    entry.older = InvalidHandle;
+}
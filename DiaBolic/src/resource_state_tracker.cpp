@@ -0,0 +1,204 @@
+#include "resource_state_tracker.hpp"
+
+#include "utility/dx12_helpers.hpp"
+
+using namespace Util;
+
+namespace
+{
+    // Number of subresources a barrier with D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES covers.
+    UINT GetSubresourceCount(ID3D12Resource* resource)
+    {
+        const CD3DX12_RESOURCE_DESC desc(resource->GetDesc());
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return 1;
+        }
+
+        Microsoft::WRL::ComPtr<ID3D12Device> device;
+        ThrowIfFailed(resource->GetDevice(IID_PPV_ARGS(&device)));
+        return desc.Subresources(device.Get());
+    }
+}
+
+std::mutex ResourceStateTracker::s_globalMutex;
+ResourceStateTracker::TrackedStateMap ResourceStateTracker::s_globalResourceStates;
+
+void ResourceStateTracker::TrackedState::SetSubresourceState(UINT subresource, D3D12_RESOURCE_STATES subresourceState)
+{
+    if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        state = subresourceState;
+        subresourceStates.clear();
+        hasWholeState = true;
+    }
+    else
+    {
+        subresourceStates[subresource] = subresourceState;
+    }
+}
+
+D3D12_RESOURCE_STATES ResourceStateTracker::TrackedState::GetSubresourceState(UINT subresource) const
+{
+    const auto it = subresourceStates.find(subresource);
+    return it != subresourceStates.end() ? it->second : state;
+}
+
+bool ResourceStateTracker::TrackedState::IsSubresourceKnown(UINT subresource) const
+{
+    return hasWholeState || subresourceStates.contains(subresource);
+}
+
+void ResourceStateTracker::TransitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES stateAfter, UINT subresource)
+{
+    const auto it = _finalResourceStates.find(resource);
+    if (it == _finalResourceStates.end())
+    {
+        // First use in this command list, the state before is resolved on submission.
+        _pendingResourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+            D3D12_RESOURCE_STATE_COMMON, stateAfter, subresource));
+        _finalResourceStates[resource].SetSubresourceState(subresource, stateAfter);
+        return;
+    }
+
+    TrackedState& trackedState = it->second;
+    if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !trackedState.subresourceStates.empty())
+    {
+        // Subresources are in different states, transition them one by one. The ones this
+        // command list hasn't used yet are left pending, like any other first use.
+        const UINT subresourceCount = GetSubresourceCount(resource);
+        for (UINT subresourceIndex = 0; subresourceIndex < subresourceCount; ++subresourceIndex)
+        {
+            if (!trackedState.IsSubresourceKnown(subresourceIndex))
+            {
+                _pendingResourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+                    D3D12_RESOURCE_STATE_COMMON, stateAfter, subresourceIndex));
+                continue;
+            }
+
+            const D3D12_RESOURCE_STATES stateBefore = trackedState.GetSubresourceState(subresourceIndex);
+            if (stateBefore != stateAfter)
+            {
+                _resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+                    stateBefore, stateAfter, subresourceIndex));
+            }
+        }
+    }
+    else if (trackedState.IsSubresourceKnown(subresource))
+    {
+        const D3D12_RESOURCE_STATES stateBefore = trackedState.GetSubresourceState(subresource);
+        if (stateBefore != stateAfter)
+        {
+            _resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+                stateBefore, stateAfter, subresource));
+        }
+    }
+    else
+    {
+        // Only other subresources were used so far.
+        _pendingResourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource,
+            D3D12_RESOURCE_STATE_COMMON, stateAfter, subresource));
+    }
+
+    trackedState.SetSubresourceState(subresource, stateAfter);
+}
+
+void ResourceStateTracker::UAVBarrier(ID3D12Resource* resource)
+{
+    _resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+}
+
+void ResourceStateTracker::AliasBarrier(ID3D12Resource* resourceBefore, ID3D12Resource* resourceAfter)
+{
+    _resourceBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(resourceBefore, resourceAfter));
+}
+
+void ResourceStateTracker::FlushResourceBarriers(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2>& commandList)
+{
+    if (!_resourceBarriers.empty())
+    {
+        commandList->ResourceBarrier(static_cast<UINT>(_resourceBarriers.size()), _resourceBarriers.data());
+        _resourceBarriers.clear();
+    }
+}
+
+std::vector<D3D12_RESOURCE_BARRIER> ResourceStateTracker::ResolvePendingResourceBarriers() const
+{
+    std::vector<D3D12_RESOURCE_BARRIER> resolvedBarriers;
+    resolvedBarriers.reserve(_pendingResourceBarriers.size());
+
+    for (const D3D12_RESOURCE_BARRIER& pendingBarrier : _pendingResourceBarriers)
+    {
+        const D3D12_RESOURCE_TRANSITION_BARRIER& transition = pendingBarrier.Transition;
+
+        // Resources nobody registered were created in (or decayed to) the common state.
+        const auto it = s_globalResourceStates.find(transition.pResource);
+        const TrackedState globalState = it != s_globalResourceStates.end() ? it->second : TrackedState{ D3D12_RESOURCE_STATE_COMMON, true };
+
+        if (transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !globalState.subresourceStates.empty())
+        {
+            // Subresources without their own entry are in the whole resource's state.
+            const UINT subresourceCount = GetSubresourceCount(transition.pResource);
+            for (UINT subresourceIndex = 0; subresourceIndex < subresourceCount; ++subresourceIndex)
+            {
+                const D3D12_RESOURCE_STATES stateBefore = globalState.GetSubresourceState(subresourceIndex);
+                if (stateBefore != transition.StateAfter)
+                {
+                    resolvedBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(transition.pResource,
+                        stateBefore, transition.StateAfter, subresourceIndex));
+                }
+            }
+        }
+        else
+        {
+            const D3D12_RESOURCE_STATES stateBefore = globalState.GetSubresourceState(transition.Subresource);
+            if (stateBefore != transition.StateAfter)
+            {
+                resolvedBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(transition.pResource,
+                    stateBefore, transition.StateAfter, transition.Subresource));
+            }
+        }
+    }
+
+    return resolvedBarriers;
+}
+
+void ResourceStateTracker::CommitFinalResourceStates()
+{
+    for (const auto& [resource, trackedState] : _finalResourceStates)
+    {
+        TrackedState& globalState = s_globalResourceStates[resource];
+        if (trackedState.hasWholeState)
+        {
+            globalState.SetSubresourceState(D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, trackedState.state);
+        }
+        for (const auto& [subresourceIndex, subresourceState] : trackedState.subresourceStates)
+        {
+            globalState.SetSubresourceState(subresourceIndex, subresourceState);
+        }
+    }
+}
+
+void ResourceStateTracker::Reset()
+{
+    _resourceBarriers.clear();
+    _pendingResourceBarriers.clear();
+    _finalResourceStates.clear();
+}
+
+std::unique_lock<std::mutex> ResourceStateTracker::LockGlobalState()
+{
+    return std::unique_lock<std::mutex>(s_globalMutex);
+}
+
+void ResourceStateTracker::AddGlobalResourceState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+    std::lock_guard<std::mutex> lock(s_globalMutex);
+    s_globalResourceStates[resource].SetSubresourceState(D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, state);
+}
+
+void ResourceStateTracker::RemoveGlobalResourceState(ID3D12Resource* resource)
+{
+    std::lock_guard<std::mutex> lock(s_globalMutex);
+    s_globalResourceStates.erase(resource);
+}
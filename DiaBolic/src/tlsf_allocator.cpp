@@ -0,0 +1,268 @@
+#include "tlsf_allocator.hpp"
+
+#include <bit>
+#include <cassert>
+
+TlsfAllocator::TlsfAllocator(uint64_t size)
+    : _size(size)
+{
+    assert(size > 0 && "Can't manage an empty block.");
+
+    _freeLists.fill(InvalidNode);
+    _firstNode = CreateNode(0, size);
+    InsertFreeNode(_firstNode);
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(size > 0 && "Can't allocate zero bytes.");
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+    const auto alignmentPadding = [this, alignment](uint32_t node) {
+        const uint64_t offset = _nodes[node].offset;
+        return ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+    };
+
+    // Try the best size class first, only if its range is misaligned search for one that
+    // is large enough to be aligned for sure.
+    uint32_t node = FindFreeNode(size);
+    if (node != InvalidNode && alignmentPadding(node) + size > _nodes[node].size)
+    {
+        node = InvalidNode;
+    }
+    if (node == InvalidNode && alignment > 1)
+    {
+        node = FindFreeNode(size + alignment - 1);
+    }
+    if (node == InvalidNode)
+    {
+        return {};
+    }
+
+    RemoveFreeNode(node);
+
+    // Free neighbours are always merged, so the padding never has a free neighbour in front of it.
+    if (const uint64_t padding = alignmentPadding(node); padding > 0)
+    {
+        InsertFreeNode(SplitFront(node, padding));
+    }
+
+    if (_nodes[node].size > size)
+    {
+        const uint32_t usedNode = SplitFront(node, size);
+        InsertFreeNode(node);
+        node = usedNode;
+    }
+
+    _nodes[node].isFree = false;
+    ++_allocationCount;
+
+    return Allocation{ .offset = _nodes[node].offset, .size = _nodes[node].size, .node = node };
+}
+
+void TlsfAllocator::Free(const Allocation& allocation)
+{
+    uint32_t node = allocation.node;
+    assert(node < _nodes.size() && !_nodes[node].isFree && _nodes[node].offset == allocation.offset && "Invalid or already freed allocation.");
+
+    _nodes[node].isFree = true;
+    --_allocationCount;
+
+    if (const uint32_t next = _nodes[node].nextPhysical; next != InvalidNode && _nodes[next].isFree)
+    {
+        RemoveFreeNode(next);
+        _nodes[node].size += _nodes[next].size;
+        _nodes[node].nextPhysical = _nodes[next].nextPhysical;
+        if (_nodes[node].nextPhysical != InvalidNode)
+        {
+            _nodes[_nodes[node].nextPhysical].previousPhysical = node;
+        }
+        DestroyNode(next);
+    }
+
+    if (const uint32_t previous = _nodes[node].previousPhysical; previous != InvalidNode && _nodes[previous].isFree)
+    {
+        RemoveFreeNode(previous);
+        _nodes[previous].size += _nodes[node].size;
+        _nodes[previous].nextPhysical = _nodes[node].nextPhysical;
+        if (_nodes[previous].nextPhysical != InvalidNode)
+        {
+            _nodes[_nodes[previous].nextPhysical].previousPhysical = previous;
+        }
+        DestroyNode(node);
+        node = previous;
+    }
+
+    InsertFreeNode(node);
+}
+
+TlsfAllocator::Statistics TlsfAllocator::GetStatistics() const
+{
+    Statistics statistics{ .size = _size, .allocationCount = _allocationCount };
+    for (uint32_t node = _firstNode; node != InvalidNode; node = _nodes[node].nextPhysical)
+    {
+        if (_nodes[node].isFree)
+        {
+            statistics.freeSize += _nodes[node].size;
+            statistics.largestFreeRange = (std::max)(statistics.largestFreeRange, _nodes[node].size);
+            ++statistics.freeRangeCount;
+        }
+        else
+        {
+            statistics.usedSize += _nodes[node].size;
+        }
+    }
+
+    return statistics;
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+    // Sizes below SecondLevelCount are spread linearly over the first level,
+    // every level above that covers a power of two split into SecondLevelCount classes.
+    if (size < SecondLevelCount)
+    {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(size);
+        return;
+    }
+
+    const uint32_t mostSignificantBit = 63 - static_cast<uint32_t>(std::countl_zero(size));
+    firstLevel = mostSignificantBit - SecondLevelBits + 1;
+    secondLevel = static_cast<uint32_t>(size >> (mostSignificantBit - SecondLevelBits)) - SecondLevelCount;
+}
+
+uint32_t TlsfAllocator::FindFreeNode(uint64_t size) const
+{
+    // Round up to the next size class, every range in it is large enough.
+    if (size >= SecondLevelCount)
+    {
+        const uint32_t mostSignificantBit = 63 - static_cast<uint32_t>(std::countl_zero(size));
+        size += (1ull << (mostSignificantBit - SecondLevelBits)) - 1;
+    }
+
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(size, firstLevel, secondLevel);
+
+    uint32_t secondLevelBitmap = _secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelBitmap == 0)
+    {
+        const uint64_t firstLevelBitmap = firstLevel + 1 < 64 ? _firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+        if (firstLevelBitmap == 0)
+        {
+            return InvalidNode;
+        }
+
+        firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelBitmap));
+        secondLevelBitmap = _secondLevelBitmaps[firstLevel];
+    }
+
+    secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelBitmap));
+    return _freeLists[firstLevel * SecondLevelCount + secondLevel];
+}
+
+uint32_t TlsfAllocator::CreateNode(uint64_t offset, uint64_t size)
+{
+    uint32_t node;
+    if (!_unusedNodes.empty())
+    {
+        node = _unusedNodes.back();
+        _unusedNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(_nodes.size());
+        _nodes.emplace_back();
+    }
+
+    _nodes[node] = Node{ .offset = offset, .size = size, .isFree = true };
+    return node;
+}
+
+void TlsfAllocator::DestroyNode(uint32_t node)
+{
+    _nodes[node] = Node{};
+    _unusedNodes.push_back(node);
+}
+
+void TlsfAllocator::InsertFreeNode(uint32_t node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(_nodes[node].size, firstLevel, secondLevel);
+
+    uint32_t& head = _freeLists[firstLevel * SecondLevelCount + secondLevel];
+    _nodes[node].isFree = true;
+    _nodes[node].previousFree = InvalidNode;
+    _nodes[node].nextFree = head;
+    if (head != InvalidNode)
+    {
+        _nodes[head].previousFree = node;
+    }
+    head = node;
+
+    _firstLevelBitmap |= 1ull << firstLevel;
+    _secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::RemoveFreeNode(uint32_t node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(_nodes[node].size, firstLevel, secondLevel);
+
+    const uint32_t previousFree = _nodes[node].previousFree;
+    const uint32_t nextFree = _nodes[node].nextFree;
+    if (previousFree != InvalidNode)
+    {
+        _nodes[previousFree].nextFree = nextFree;
+    }
+    if (nextFree != InvalidNode)
+    {
+        _nodes[nextFree].previousFree = previousFree;
+    }
+
+    uint32_t& head = _freeLists[firstLevel * SecondLevelCount + secondLevel];
+    if (head == node)
+    {
+        head = nextFree;
+        if (head == InvalidNode)
+        {
+            _secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (_secondLevelBitmaps[firstLevel] == 0)
+            {
+                _firstLevelBitmap &= ~(1ull << firstLevel);
+            }
+        }
+    }
+
+    _nodes[node].previousFree = InvalidNode;
+    _nodes[node].nextFree = InvalidNode;
+}
+
+uint32_t TlsfAllocator::SplitFront(uint32_t node, uint64_t size)
+{
+    assert(size < _nodes[node].size && "Split has to leave something behind.");
+
+    // Creating a node can move the node storage, so only index into it afterwards.
+    const uint32_t front = CreateNode(_nodes[node].offset, size);
+    const uint32_t previous = _nodes[node].previousPhysical;
+
+    _nodes[front].previousPhysical = previous;
+    _nodes[front].nextPhysical = node;
+    if (previous != InvalidNode)
+    {
+        _nodes[previous].nextPhysical = front;
+    }
+    else
+    {
+        _firstNode = front;
+    }
+
+    _nodes[node].previousPhysical = front;
+    _nodes[node].offset += size;
+    _nodes[node].size -= size;
+
+    return front;
+}
@@ -0,0 +1,28 @@
+#include "transient_descriptor_allocator.hpp"
+
+#include <cassert>
+#include <exception>
+
+TransientDescriptorAllocator::TransientDescriptorAllocator(uint32_t firstIndex, uint32_t count)
+    : _firstIndex(firstIndex)
+    , _count(count)
+{
+}
+
+uint32_t TransientDescriptorAllocator::Allocate(uint32_t count)
+{
+    assert(count > 0 && "Can't allocate zero descriptors.");
+
+    const uint32_t offset = _offset.fetch_add(count, std::memory_order_relaxed);
+    if (offset + count > _count)
+    {
+        throw std::exception("Transient descriptors of this frame are used up.");
+    }
+
+    return _firstIndex + offset;
+}
+
+void TransientDescriptorAllocator::Reset()
+{
+    _offset.store(0, std::memory_order_relaxed);
+}
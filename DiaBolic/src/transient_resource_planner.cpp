@@ -0,0 +1,103 @@
+#include "transient_resource_planner.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    bool LifetimesOverlap(const TransientResourcePlanner::Request& a, const TransientResourcePlanner::Request& b)
+    {
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    }
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+void TransientResourcePlanner::Plan(std::span<const Request> requests)
+{
+    const uint32_t requestCount = static_cast<uint32_t>(requests.size());
+
+    _placements.assign(requestCount, Placement{});
+    _size = 0;
+    _unaliasedSize = 0;
+
+    _order.resize(requestCount);
+    for (uint32_t i = 0; i < requestCount; ++i)
+    {
+        assert(requests[i].alignment > 0 && (requests[i].alignment & (requests[i].alignment - 1)) == 0 && "Alignment must be a power of two.");
+        assert(requests[i].firstPass <= requests[i].lastPass && "Lifetime ends before it starts.");
+        _order[i] = i;
+        _unaliasedSize += requests[i].size;
+    }
+
+    // Large resources are the hardest to fit, place them while the memory is still empty.
+    std::sort(_order.begin(), _order.end(), [&](uint32_t a, uint32_t b) {
+        if (requests[a].size != requests[b].size)
+        {
+            return requests[a].size > requests[b].size;
+        }
+        return requests[a].firstPass < requests[b].firstPass;
+    });
+
+    _placed.clear();
+    for (const uint32_t resource : _order)
+    {
+        const Request& request = requests[resource];
+
+        _collisions.clear();
+        for (const uint32_t other : _placed)
+        {
+            if (LifetimesOverlap(request, requests[other]))
+            {
+                _collisions.push_back(other);
+            }
+        }
+        std::sort(_collisions.begin(), _collisions.end(), [&](uint32_t a, uint32_t b) {
+            return _placements[a].offset < _placements[b].offset;
+        });
+
+        // First gap in between the resources living at the same time that is large enough.
+        uint64_t offset = 0;
+        for (const uint32_t other : _collisions)
+        {
+            if (offset + request.size <= _placements[other].offset)
+            {
+                break;
+            }
+            offset = (std::max)(offset, AlignUp(_placements[other].offset + requests[other].size, request.alignment));
+        }
+
+        _placements[resource].offset = offset;
+        _size = (std::max)(_size, offset + request.size);
+        _placed.push_back(resource);
+    }
+
+    // Find out whose memory every resource takes over.
+    for (uint32_t resource = 0; resource < requestCount; ++resource)
+    {
+        const Request& request = requests[resource];
+        Placement& placement = _placements[resource];
+
+        uint32_t previousCount = 0;
+        for (uint32_t other = 0; other < requestCount; ++other)
+        {
+            const bool livedBefore = requests[other].lastPass < request.firstPass;
+            const bool sharesMemory = _placements[other].offset < placement.offset + request.size &&
+                placement.offset < _placements[other].offset + requests[other].size;
+            if (livedBefore && sharesMemory)
+            {
+                placement.aliasedResource = other;
+                ++previousCount;
+            }
+        }
+
+        placement.isAliased = previousCount > 0;
+        if (previousCount > 1)
+        {
+            placement.aliasedResource = NoResource;
+        }
+    }
+}
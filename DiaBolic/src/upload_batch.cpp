@@ -0,0 +1,129 @@
+#include "upload_batch.hpp"
+
+#include "command_queue.hpp"
+#include "upload_ring.hpp"
+#include "utility/resource_util.hpp"
+
+UploadBatch::UploadBatch(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, GpuMemoryAllocator& memoryAllocator,
+    UploadRing& uploadRing, CommandQueue& copyQueue)
+    : _device(device)
+    , _memoryAllocator(memoryAllocator)
+    , _uploadRing(uploadRing)
+    , _copyQueue(copyQueue)
+{
+}
+
+UploadBatch::~UploadBatch()
+{
+    assert(_uploads.empty() && "Upload batch was destroyed before it was submitted.");
+}
+
+void UploadBatch::AddBuffer(ID3D12Resource** ppDestination, GpuAllocation& destinationMemory,
+    const void* data, size_t size, D3D12_RESOURCE_FLAGS flags)
+{
+    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+    destinationMemory = _memoryAllocator.CreateResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, ppDestination);
+
+    if (!data)
+    {
+        return;
+    }
+
+    _uploads.push_back({
+        .destination = *ppDestination,
+        .stagingOffset = ReserveStaging(size, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT),
+        .data = data,
+        .size = size,
+    });
+}
+
+void UploadBatch::AddTextureFromFile(ID3D12Resource** ppDestination, GpuAllocation& destinationMemory,
+    const std::wstring& fileName, DXGI_FORMAT& format)
+{
+    auto image = std::make_unique<DirectX::ScratchImage>();
+    const D3D12_RESOURCE_DESC textureDesc = Util::LoadImageFromFile(fileName, *image);
+    format = textureDesc.Format;
+
+    destinationMemory = _memoryAllocator.CreateResource(textureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, ppDestination);
+
+    const UINT subresourceCount = static_cast<UINT>(image->GetImageCount());
+    Upload upload{
+        .destination = *ppDestination,
+        .image = std::move(image),
+        .layouts = std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>(subresourceCount),
+        .rowCounts = std::vector<UINT>(subresourceCount),
+        .rowSizes = std::vector<UINT64>(subresourceCount),
+    };
+
+    // Footprints are relative to the start of this texture's staging data.
+    UINT64 requiredSize = 0;
+    _device->GetCopyableFootprints(&textureDesc, 0, subresourceCount, 0,
+        upload.layouts.data(), upload.rowCounts.data(), upload.rowSizes.data(), &requiredSize);
+
+    // Texture data in a buffer has to start at a 512 byte aligned offset.
+    upload.stagingOffset = ReserveStaging(requiredSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    _uploads.push_back(std::move(upload));
+}
+
+FenceSignal UploadBatch::Submit()
+{
+    if (_uploads.empty())
+    {
+        return _copyQueue.Signal();
+    }
+
+    const UploadRing::Allocation staging = _uploadRing.Allocate(_stagingSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    uint8_t* stagingData = static_cast<uint8_t*>(staging.cpuAddress);
+
+    // No barriers needed: destinations are created in COMMON and implicitly promoted to COPY_DEST by the copies,
+    // and anything accessed on a copy queue decays back to COMMON once the copy queue is done.
+    // The queue that uses them next can then promote them to whatever it needs.
+    auto commandList = _copyQueue.GetCommandList();
+    for (Upload& upload : _uploads)
+    {
+        if (!upload.image)
+        {
+            memcpy(stagingData + upload.stagingOffset, upload.data, upload.size);
+            commandList->CopyBufferRegion(upload.destination, 0, staging.resource, staging.offset + upload.stagingOffset, upload.size);
+            continue;
+        }
+
+        const DirectX::Image* pImages = upload.image->GetImages();
+        for (UINT i = 0; i < static_cast<UINT>(upload.layouts.size()); ++i)
+        {
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = upload.layouts[i];
+
+            const D3D12_MEMCPY_DEST destData = {
+                .pData = stagingData + upload.stagingOffset + layout.Offset,
+                .RowPitch = layout.Footprint.RowPitch,
+                .SlicePitch = SIZE_T(layout.Footprint.RowPitch) * upload.rowCounts[i],
+            };
+            const D3D12_SUBRESOURCE_DATA srcData = {
+                .pData = pImages[i].pixels,
+                .RowPitch = static_cast<LONG_PTR>(pImages[i].rowPitch),
+                .SlicePitch = static_cast<LONG_PTR>(pImages[i].slicePitch),
+            };
+            MemcpySubresource(&destData, &srcData, static_cast<SIZE_T>(upload.rowSizes[i]), upload.rowCounts[i], layout.Footprint.Depth);
+
+            layout.Offset += staging.offset + upload.stagingOffset;
+            const CD3DX12_TEXTURE_COPY_LOCATION dst(upload.destination, i);
+            const CD3DX12_TEXTURE_COPY_LOCATION src(staging.resource, layout);
+            commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        }
+    }
+
+    const FenceSignal signal = _copyQueue.ExecuteCommandList(commandList);
+    _uploadRing.Submit(signal);
+
+    _uploads.clear();
+    _stagingSize = 0;
+
+    return signal;
+}
+
+uint64_t UploadBatch::ReserveStaging(uint64_t size, uint64_t alignment)
+{
+    const uint64_t offset = (_stagingSize + alignment - 1) & ~(alignment - 1);
+    _stagingSize = offset + size;
+    return offset;
+}
@@ -0,0 +1,60 @@
+#include "upload_buffer.hpp"
+
+#include "utility/dx12_helpers.hpp"
+
+UploadBuffer::UploadBuffer(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t size, const std::wstring& name)
+    : _size(size)
+{
+    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(_size);
+    Util::ThrowIfFailed(device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&_resource)));
+    _resource->SetName(name.c_str());
+
+    // Upload heaps may stay mapped for the lifetime of the resource.
+    // We never read from this memory on the CPU, so pass an empty read range.
+    const CD3DX12_RANGE readRange(0, 0);
+    Util::ThrowIfFailed(_resource->Map(0, &readRange, reinterpret_cast<void**>(&_cpuAddress)));
+    _gpuAddress = _resource->GetGPUVirtualAddress();
+}
+
+UploadBuffer::~UploadBuffer()
+{
+    if (_resource)
+    {
+        _resource->Unmap(0, nullptr);
+    }
+}
+
+UploadBuffer::Allocation UploadBuffer::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+    uint64_t offset = _offset.load(std::memory_order_relaxed);
+    uint64_t alignedOffset;
+    do
+    {
+        alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+        if (alignedOffset + size > _size)
+        {
+            throw std::exception("Upload buffer is out of memory.");
+        }
+    } while (!_offset.compare_exchange_weak(offset, alignedOffset + size, std::memory_order_relaxed));
+
+    return Allocation{
+        .cpuAddress = _cpuAddress + alignedOffset,
+        .gpuAddress = _gpuAddress + alignedOffset,
+        .offset = alignedOffset,
+        .resource = _resource.Get(),
+    };
+}
+
+void UploadBuffer::Reset()
+{
+    _offset.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,110 @@
+#include "upload_ring.hpp"
+
+#include "command_queue.hpp"
+#include "utility/dx12_helpers.hpp"
+
+UploadRing::UploadRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandQueue& queue, uint64_t size, const std::wstring& name)
+    : _queue(queue)
+    , _size(size)
+{
+    CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(_size);
+    Util::ThrowIfFailed(device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&_resource)));
+    _resource->SetName(name.c_str());
+
+    const CD3DX12_RANGE readRange(0, 0);
+    Util::ThrowIfFailed(_resource->Map(0, &readRange, reinterpret_cast<void**>(&_cpuAddress)));
+    _gpuAddress = _resource->GetGPUVirtualAddress();
+}
+
+UploadRing::~UploadRing()
+{
+    if (_resource)
+    {
+        _resource->Unmap(0, nullptr);
+    }
+}
+
+UploadRing::Allocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+    assert(_size % alignment == 0 && "Alignment must divide the ring size.");
+
+    if (size > _size)
+    {
+        throw std::exception("Upload is larger than the upload ring.");
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint64_t position = (_tail + alignment - 1) & ~(alignment - 1);
+    if (position % _size + size > _size)
+    {
+        // Allocations never wrap, skip the rest of the buffer.
+        position = (position / _size + 1) * _size;
+    }
+
+    if (position + size - _head > _size)
+    {
+        Reclaim(_queue.GetFence()->GetCompletedValue());
+    }
+
+    while (position + size - _head > _size)
+    {
+        if (_submissions.empty())
+        {
+            // Everything in use was allocated for copies that weren't submitted yet.
+            throw std::exception("Upload ring is out of memory.");
+        }
+
+        _queue.WaitForFenceValue(_submissions.front().fenceValue);
+        Reclaim(_submissions.front().fenceValue);
+    }
+
+    _tail = position + size;
+
+    const uint64_t offset = position % _size;
+    return Allocation{
+        .cpuAddress = _cpuAddress + offset,
+        .gpuAddress = _gpuAddress + offset,
+        .offset = offset,
+        .resource = _resource.Get(),
+    };
+}
+
+void UploadRing::Submit(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_tail == _submittedTail)
+    {
+        return;
+    }
+
+    assert((_submissions.empty() || _submissions.back().fenceValue <= fenceValue) && "Submissions must be in fence order.");
+    _submissions.push_back({ fenceValue, _tail });
+    _submittedTail = _tail;
+}
+
+uint64_t UploadRing::GetUsedSize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tail - _head;
+}
+
+void UploadRing::Reclaim(uint64_t completedFenceValue)
+{
+    while (!_submissions.empty() && _submissions.front().fenceValue <= completedFenceValue)
+    {
+        _head = _submissions.front().end;
+        _submissions.pop_front();
+    }
+
+    // Positions are never reset, Allocate() computed its position from _tail before reclaiming.
+}
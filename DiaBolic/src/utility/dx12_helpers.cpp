@@ -157,4 +157,17 @@ void Util::CheckFeatureSupport(const Microsoft::WRL::ComPtr<ID3D12Device>& devic
             dblog::info("[DEVICE] Supported Shader Model: {}", model.c_str());
         }
     }
+}
+
+uint32_t Util::GetMaxShaderVisibleDescriptorCount(const Microsoft::WRL::ComPtr<ID3D12Device>& device)
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+    if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) ||
+        options.ResourceBindingTier == D3D12_RESOURCE_BINDING_TIER_1)
+    {
+        return D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1;
+    }
+
+    // Tier 3 hardware may support more, but that isn't reported anywhere.
+    return D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_2;
 }
\ No newline at end of file
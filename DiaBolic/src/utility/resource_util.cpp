@@ -67,57 +67,7 @@ void Util::CreateCube(
     }
 }
 
-void Util::LoadBufferResource(
-    Microsoft::WRL::ComPtr<ID3D12Device> device,
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-	ID3D12Resource** pDestinationResource,
-	ID3D12Resource** pIntermediateResource,
-	size_t numElements, size_t elementSize,
-	const void* bufferData, D3D12_RESOURCE_FLAGS flags)
-{
-    size_t bufferSize = numElements * elementSize;
-
-    {   // Create a committed resource for the GPU resource in a default heap.
-        CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
-        CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize, flags);
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(pDestinationResource)));
-    }
-
-    // Create an committed resource for the upload.
-    if (bufferData)
-    {
-        CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-        CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(pIntermediateResource)));
-
-        D3D12_SUBRESOURCE_DATA subresourceData = {};
-        subresourceData.pData = bufferData;
-        subresourceData.RowPitch = bufferSize;
-        subresourceData.SlicePitch = subresourceData.RowPitch;
-
-        UpdateSubresources(commandList.Get(),
-            *pDestinationResource, *pIntermediateResource,
-            0, 0, 1, &subresourceData);
-    }
-}
-
-void Util::LoadTextureFromFile(
-    Microsoft::WRL::ComPtr<ID3D12Device> device,
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-    ID3D12Resource** pDestinationResource, ID3D12Resource** pIntermediateResource,
-    const std::wstring& fileName, DXGI_FORMAT& format)
+D3D12_RESOURCE_DESC Util::LoadImageFromFile(const std::wstring& fileName, DirectX::ScratchImage& scratchImage)
 {
     fs::path filePath(fileName);
     if (!exists(filePath))
@@ -126,7 +76,6 @@ void Util::LoadTextureFromFile(
     }
 
     DirectX::TexMetadata metadata;
-    DirectX::ScratchImage scratchImage;
 
     if (filePath.extension() == ".dds")
     {
@@ -185,54 +134,6 @@ void Util::LoadTextureFromFile(
     default:
         throw std::exception("Invalid texture dimension.");
     }
-    format = metadata.format;
-    
-    CD3DX12_HEAP_PROPERTIES textureHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-    ThrowIfFailed(device->CreateCommittedResource(
-        &textureHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &textureDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        nullptr,
-        IID_PPV_ARGS(pDestinationResource)));
-
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
-    const DirectX::Image* pImages = scratchImage.GetImages();
-    for (int i = 0; i < scratchImage.GetImageCount(); ++i)
-    {
-        auto& subresource = subresources[i];
-        subresource.RowPitch = pImages[i].rowPitch;
-        subresource.SlicePitch = pImages[i].slicePitch;
-        subresource.pData = pImages[i].pixels;
-    }
-
-    if (pDestinationResource)
-    {
-        TransitionResource(commandList, *pDestinationResource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
-
-        UINT64 requiredSize = GetRequiredIntermediateSize(*pDestinationResource, 0, static_cast<uint32_t>(subresources.size()));
-
-        D3D12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(requiredSize);
-        CD3DX12_HEAP_PROPERTIES bufferHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        ThrowIfFailed(device->CreateCommittedResource(
-            &bufferHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(pIntermediateResource)
-        ));
-        UpdateSubresources(commandList.Get(), *pDestinationResource, *pIntermediateResource, 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
-    }
-}
-
-void Util::TransitionResource(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> commandList,
-    Microsoft::WRL::ComPtr<ID3D12Resource> resource,
-    D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
-{
-    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        resource.Get(),
-        beforeState, afterState);
 
-    commandList->ResourceBarrier(1, &barrier);
+    return textureDesc;
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "utility/thread_pool.hpp"
+
+#include <utility>
+
+Util::ThreadPool::ThreadPool(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        _workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+Util::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wakeCondition.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void Util::ThreadPool::Execute(uint32_t taskCount, const std::function<void(uint32_t)>& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _taskCount = taskCount;
+        _nextTask = 0;
+        _finishedTasks = 0;
+        _exception = nullptr;
+        ++_generation;
+    }
+    _wakeCondition.notify_all();
+
+    // The calling thread helps out instead of idling.
+    RunTasks();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this] { return _finishedTasks == _taskCount; });
+    _task = nullptr;
+
+    if (_exception)
+    {
+        std::rethrow_exception(std::exchange(_exception, nullptr));
+    }
+}
+
+void Util::ThreadPool::WorkerLoop()
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeCondition.wait(lock, [&] { return _stop || _generation != seenGeneration; });
+            if (_stop)
+            {
+                return;
+            }
+            seenGeneration = _generation;
+        }
+
+        RunTasks();
+    }
+}
+
+void Util::ThreadPool::RunTasks()
+{
+    while (true)
+    {
+        uint32_t taskIndex;
+        const std::function<void(uint32_t)>* task;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_task || _nextTask >= _taskCount)
+            {
+                return;
+            }
+            taskIndex = _nextTask++;
+            task = _task;
+        }
+
+        // An exception must not escape a worker, it's handed to the thread that called Execute().
+        std::exception_ptr exception;
+        try
+        {
+            (*task)(taskIndex);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        bool allFinished;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (exception && !_exception)
+            {
+                _exception = exception;
+            }
+            allFinished = ++_finishedTasks == _taskCount;
+        }
+        if (allFinished)
+        {
+            _doneCondition.notify_all();
+        }
+    }
+}
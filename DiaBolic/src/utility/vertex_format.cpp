@@ -0,0 +1,195 @@
+#include "utility/vertex_format.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr float QuantizedPositionMax = 65535.0f;
+    constexpr float SnormMax = 127.0f;
+
+    uint32_t QuantizeSnorm8(float value)
+    {
+        const float clamped = std::clamp(value, -1.0f, 1.0f);
+        return static_cast<uint32_t>(static_cast<int32_t>(std::round(clamped * SnormMax))) & 0xFFu;
+    }
+
+    float DequantizeSnorm8(uint32_t value)
+    {
+        return (std::max)(static_cast<float>(static_cast<int8_t>(value)) / SnormMax, -1.0f);
+    }
+
+    float SignNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+Util::VertexQuantization Util::ComputeVertexQuantization(std::span<const float> positions)
+{
+    assert(positions.size() % 3 == 0 && "Positions have to be xyz triplets.");
+
+    VertexQuantization quantization{};
+    if (positions.empty())
+    {
+        return quantization;
+    }
+
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        float minimum = std::numeric_limits<float>::max();
+        float maximum = std::numeric_limits<float>::lowest();
+        for (size_t i = axis; i < positions.size(); i += 3)
+        {
+            minimum = (std::min)(minimum, positions[i]);
+            maximum = (std::max)(maximum, positions[i]);
+        }
+
+        quantization.offset[axis] = minimum;
+        quantization.scale[axis] = (maximum - minimum) / QuantizedPositionMax;
+    }
+
+    return quantization;
+}
+
+Util::PackedVertex Util::PackVertex(const float position[3], const float normal[3], const float uv[2],
+    const VertexQuantization& quantization)
+{
+    uint32_t quantized[3];
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        // A flat axis only has the offset.
+        const float scale = quantization.scale[axis];
+        const float value = scale > 0.0f ? (position[axis] - quantization.offset[axis]) / scale : 0.0f;
+        quantized[axis] = static_cast<uint32_t>(std::clamp(std::round(value), 0.0f, QuantizedPositionMax));
+    }
+
+    return PackedVertex{
+        .positionXY = quantized[0] | (quantized[1] << 16),
+        .positionZNormal = quantized[2] | (static_cast<uint32_t>(EncodeOctahedral(normal)) << 16),
+        .uv = static_cast<uint32_t>(FloatToHalf(uv[0])) | (static_cast<uint32_t>(FloatToHalf(uv[1])) << 16),
+    };
+}
+
+void Util::UnpackVertex(const PackedVertex& vertex, const VertexQuantization& quantization,
+    float position[3], float normal[3], float uv[2])
+{
+    const uint32_t quantized[3] = { vertex.positionXY & 0xFFFFu, vertex.positionXY >> 16, vertex.positionZNormal & 0xFFFFu };
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        position[axis] = quantization.offset[axis] + static_cast<float>(quantized[axis]) * quantization.scale[axis];
+    }
+
+    DecodeOctahedral(static_cast<uint16_t>(vertex.positionZNormal >> 16), normal);
+
+    uv[0] = HalfToFloat(static_cast<uint16_t>(vertex.uv & 0xFFFFu));
+    uv[1] = HalfToFloat(static_cast<uint16_t>(vertex.uv >> 16));
+}
+
+std::vector<Util::PackedVertex> Util::PackVertices(std::span<const float> positions, std::span<const float> normals,
+    std::span<const float> uvs, VertexQuantization& quantization)
+{
+    const size_t vertexCount = positions.size() / 3;
+    assert(normals.size() == vertexCount * 3 && uvs.size() == vertexCount * 2 && "Vertex streams differ in length.");
+
+    quantization = ComputeVertexQuantization(positions);
+
+    std::vector<PackedVertex> vertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        vertices[i] = PackVertex(&positions[i * 3], &normals[i * 3], &uvs[i * 2], quantization);
+    }
+
+    return vertices;
+}
+
+uint16_t Util::EncodeOctahedral(const float normal[3])
+{
+    // Project on the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper one.
+    const float length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    if (length == 0.0f)
+    {
+        return 0;
+    }
+
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    if (normal[2] < 0.0f)
+    {
+        const float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+        const float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return static_cast<uint16_t>(QuantizeSnorm8(x) | (QuantizeSnorm8(y) << 8));
+}
+
+void Util::DecodeOctahedral(uint16_t encoded, float normal[3])
+{
+    float x = DequantizeSnorm8(encoded & 0xFFu);
+    float y = DequantizeSnorm8(encoded >> 8);
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+
+    // Unfold the lower half.
+    const float t = (std::max)(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    const float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+uint16_t Util::FloatToHalf(float value)
+{
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t absolute = bits & 0x7FFFFFFFu;
+
+    // NaN stays NaN, infinity and everything too large for a half becomes infinity.
+    if (absolute > 0x7F800000u)
+    {
+        return static_cast<uint16_t>(sign | 0x7E00u);
+    }
+    if (absolute >= 0x477FF000u)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+
+    // Too small for a normal half, let the float unit do the rounding to a denormal.
+    if (absolute < 0x38800000u)
+    {
+        const float denormal = std::bit_cast<float>(absolute) + 0.5f;
+        return static_cast<uint16_t>(sign | (std::bit_cast<uint32_t>(denormal) - std::bit_cast<uint32_t>(0.5f)));
+    }
+
+    // Rebias the exponent and round the mantissa to nearest even.
+    const uint32_t odd = (absolute >> 13) & 1u;
+    const uint32_t rounded = absolute + 0xC8000FFFu + odd;
+    return static_cast<uint16_t>(sign | (rounded >> 13));
+}
+
+float Util::HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1Fu;
+    const uint32_t mantissa = value & 0x3FFu;
+
+    if (exponent == 0x1Fu)
+    {
+        return std::bit_cast<float>(sign | 0x7F800000u | (mantissa << 13));
+    }
+    if (exponent == 0)
+    {
+        // Denormal, exactly representable as a float.
+        const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -magnitude : magnitude;
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
@@ -0,0 +1,111 @@
+#include "view_cache.hpp"
+
+#include <cassert>
+
+size_t ViewCache::KeyHash::operator()(const Key& key) const
+{
+    // FNV-1a over everything that identifies the view.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const auto combine = [&hash](const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    combine(&key.type, sizeof(key.type));
+    combine(&key.resource, sizeof(key.resource));
+    combine(key.desc.data(), key.descSize);
+
+    return static_cast<size_t>(hash);
+}
+
+bool ViewCache::Release(const DescriptorAllocation& allocation)
+{
+    KeyShard& keyShard = GetKeyShard(allocation.index);
+    Key key;
+    {
+        std::lock_guard<std::mutex> lock(keyShard.mutex);
+        const auto keyIt = keyShard.keys.find(allocation.index);
+        assert(keyIt != keyShard.keys.end() && "View was not created through the cache.");
+        key = keyIt->second;
+    }
+
+    {
+        EntryShard& entryShard = GetEntryShard(key);
+        std::lock_guard<std::mutex> lock(entryShard.mutex);
+
+        const auto entryIt = entryShard.entries.find(key);
+        assert(entryIt->second.allocation.generation == allocation.generation && "View was already released.");
+
+        if (--entryIt->second.referenceCount > 0)
+        {
+            return false;
+        }
+
+        entryShard.entries.erase(entryIt);
+    }
+
+    // Nobody can find the view anymore, so nobody can add a new key for this index before it's freed.
+    std::lock_guard<std::mutex> lock(keyShard.mutex);
+    keyShard.keys.erase(allocation.index);
+    return true;
+}
+
+size_t ViewCache::GetViewCount() const
+{
+    size_t viewCount = 0;
+    for (const EntryShard& entryShard : _entryShards)
+    {
+        std::lock_guard<std::mutex> lock(entryShard.mutex);
+        viewCount += entryShard.entries.size();
+    }
+
+    return viewCount;
+}
+
+DescriptorAllocation ViewCache::Acquire(const Key& key)
+{
+    EntryShard& entryShard = GetEntryShard(key);
+    std::lock_guard<std::mutex> lock(entryShard.mutex);
+
+    const auto it = entryShard.entries.find(key);
+    if (it == entryShard.entries.end())
+    {
+        return {};
+    }
+
+    ++it->second.referenceCount;
+    return it->second.allocation;
+}
+
+DescriptorAllocation ViewCache::Add(const Key& key, const DescriptorAllocation& allocation)
+{
+    // The key goes in first, the view can be released as soon as other threads can find it.
+    KeyShard& keyShard = GetKeyShard(allocation.index);
+    {
+        std::lock_guard<std::mutex> lock(keyShard.mutex);
+        keyShard.keys.emplace(allocation.index, key);
+    }
+
+    DescriptorAllocation cachedAllocation;
+    {
+        EntryShard& entryShard = GetEntryShard(key);
+        std::lock_guard<std::mutex> lock(entryShard.mutex);
+
+        const auto [it, inserted] = entryShard.entries.try_emplace(key, Entry{ allocation, 1u });
+        if (inserted)
+        {
+            return allocation;
+        }
+
+        ++it->second.referenceCount;
+        cachedAllocation = it->second.allocation;
+    }
+
+    std::lock_guard<std::mutex> lock(keyShard.mutex);
+    keyShard.keys.erase(allocation.index);
+    return cachedAllocation;
+}
@@ -0,0 +1,85 @@
+#include "view_desc_keys.hpp"
+
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc)
+{
+    writer.Write(desc.BufferLocation, desc.SizeInBytes);
+}
+
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc)
+{
+    writer.Write(desc.Format, desc.ViewDimension, desc.Shader4ComponentMapping);
+
+    switch (desc.ViewDimension)
+    {
+    case D3D12_SRV_DIMENSION_BUFFER:
+        writer.Write(desc.Buffer.FirstElement, desc.Buffer.NumElements, desc.Buffer.StructureByteStride, desc.Buffer.Flags);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE1D:
+        writer.Write(desc.Texture1D.MostDetailedMip, desc.Texture1D.MipLevels, desc.Texture1D.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE1DARRAY:
+        writer.Write(desc.Texture1DArray.MostDetailedMip, desc.Texture1DArray.MipLevels, desc.Texture1DArray.FirstArraySlice,
+            desc.Texture1DArray.ArraySize, desc.Texture1DArray.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE2D:
+        writer.Write(desc.Texture2D.MostDetailedMip, desc.Texture2D.MipLevels, desc.Texture2D.PlaneSlice, desc.Texture2D.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE2DARRAY:
+        writer.Write(desc.Texture2DArray.MostDetailedMip, desc.Texture2DArray.MipLevels, desc.Texture2DArray.FirstArraySlice,
+            desc.Texture2DArray.ArraySize, desc.Texture2DArray.PlaneSlice, desc.Texture2DArray.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE2DMS:
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY:
+        writer.Write(desc.Texture2DMSArray.FirstArraySlice, desc.Texture2DMSArray.ArraySize);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURE3D:
+        writer.Write(desc.Texture3D.MostDetailedMip, desc.Texture3D.MipLevels, desc.Texture3D.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURECUBE:
+        writer.Write(desc.TextureCube.MostDetailedMip, desc.TextureCube.MipLevels, desc.TextureCube.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_TEXTURECUBEARRAY:
+        writer.Write(desc.TextureCubeArray.MostDetailedMip, desc.TextureCubeArray.MipLevels, desc.TextureCubeArray.First2DArrayFace,
+            desc.TextureCubeArray.NumCubes, desc.TextureCubeArray.ResourceMinLODClamp);
+        break;
+    case D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE:
+        writer.Write(desc.RaytracingAccelerationStructure.Location);
+        break;
+    default:
+        assert(false && "Unsupported shader resource view dimension.");
+        break;
+    }
+}
+
+void WriteViewKey(ViewKeyWriter& writer, const D3D12_UNORDERED_ACCESS_VIEW_DESC& desc)
+{
+    writer.Write(desc.Format, desc.ViewDimension);
+
+    switch (desc.ViewDimension)
+    {
+    case D3D12_UAV_DIMENSION_BUFFER:
+        writer.Write(desc.Buffer.FirstElement, desc.Buffer.NumElements, desc.Buffer.StructureByteStride,
+            desc.Buffer.CounterOffsetInBytes, desc.Buffer.Flags);
+        break;
+    case D3D12_UAV_DIMENSION_TEXTURE1D:
+        writer.Write(desc.Texture1D.MipSlice);
+        break;
+    case D3D12_UAV_DIMENSION_TEXTURE1DARRAY:
+        writer.Write(desc.Texture1DArray.MipSlice, desc.Texture1DArray.FirstArraySlice, desc.Texture1DArray.ArraySize);
+        break;
+    case D3D12_UAV_DIMENSION_TEXTURE2D:
+        writer.Write(desc.Texture2D.MipSlice, desc.Texture2D.PlaneSlice);
+        break;
+    case D3D12_UAV_DIMENSION_TEXTURE2DARRAY:
+        writer.Write(desc.Texture2DArray.MipSlice, desc.Texture2DArray.FirstArraySlice, desc.Texture2DArray.ArraySize,
+            desc.Texture2DArray.PlaneSlice);
+        break;
+    case D3D12_UAV_DIMENSION_TEXTURE3D:
+        writer.Write(desc.Texture3D.MipSlice, desc.Texture3D.FirstWSlice, desc.Texture3D.WSize);
+        break;
+    default:
+        assert(false && "Unsupported unordered access view dimension.");
+        break;
+    }
+}
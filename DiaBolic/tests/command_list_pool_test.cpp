@@ -0,0 +1,144 @@
+#include "test.hpp"
+
+#include "command_list_pool.hpp"
+#include "utility/thread_pool.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t MaxAllocatorCount = 4;
+    constexpr auto IdleTimeout = std::chrono::seconds(5);
+
+    // Stand-ins for the D3D12 allocator and list, only their identity matters.
+    using TestPool = CommandListPool<uint32_t, uint32_t>;
+
+    struct Recording
+    {
+        uint32_t allocator;
+        uint32_t commandList;
+    };
+
+    // What CommandQueue::GetCommandList() does with the pool.
+    Recording Acquire(TestPool& pool, uint32_t& createdCount, uint64_t completedFenceValue)
+    {
+        std::lock_guard<std::mutex> lock(pool.GetMutex());
+        pool.CollectRetired();
+
+        const std::optional<uint32_t> allocator = pool.AcquireAllocator(completedFenceValue, [](uint64_t) {
+            throw std::logic_error("Nothing is in flight, there is nothing to wait for.");
+        });
+        const std::optional<uint32_t> commandList = pool.AcquireCommandList();
+
+        return Recording{ allocator ? *allocator : createdCount++, commandList ? *commandList : createdCount++ };
+    }
+}
+
+TEST_CASE(CommandListPoolKeepsDiscardedAllocators)
+{
+    Util::ThreadPool threadPool(2);
+    TestPool pool(MaxAllocatorCount, IdleTimeout);
+    uint32_t createdCount = 0;
+
+    // Every frame a task throws halfway, as CommandRecorder::Submit() sees it. The recorded lists
+    // are discarded, many more frames than the cap allows fail without running out of allocators.
+    constexpr uint32_t TaskCount = 3;
+    for (uint32_t frame = 0; frame < MaxAllocatorCount * 4; ++frame)
+    {
+        std::vector<std::optional<Recording>> recordings(TaskCount);
+        bool caught = false;
+        try
+        {
+            threadPool.Execute(TaskCount, [&](uint32_t taskIndex) {
+                recordings[taskIndex] = Acquire(pool, createdCount, 0);
+                if (taskIndex == 1)
+                {
+                    throw std::runtime_error("pass failed");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+            for (const std::optional<Recording>& recording : recordings)
+            {
+                if (recording)
+                {
+                    pool.Retire(recording->allocator, recording->commandList, 0);
+                }
+            }
+        }
+        CHECK(caught);
+    }
+
+    CHECK(pool.GetAllocatorCount() == TaskCount);
+
+    // A frame that succeeds afterwards reuses the discarded allocators instead of creating new ones.
+    const uint32_t previousCreatedCount = createdCount;
+    for (uint32_t i = 0; i < TaskCount; ++i)
+    {
+        const Recording recording = Acquire(pool, createdCount, 0);
+        pool.Retire(recording.allocator, recording.commandList, 1);
+    }
+    CHECK(createdCount == previousCreatedCount);
+    CHECK(pool.GetAllocatorCount() == TaskCount);
+}
+
+TEST_CASE(CommandListPoolWaitsForTheOldestAllocatorAtTheCap)
+{
+    TestPool pool(MaxAllocatorCount, IdleTimeout);
+
+    for (uint32_t i = 0; i < MaxAllocatorCount; ++i)
+    {
+        CHECK(!pool.AcquireAllocator(0, [](uint64_t) {}).has_value());
+        pool.Retire(i, i, i + 1);
+    }
+    pool.CollectRetired();
+
+    // Nothing completed yet, the allocator retired with the lowest fence value is waited for.
+    uint64_t waitedFenceValue = 0;
+    const std::optional<uint32_t> allocator = pool.AcquireAllocator(0, [&](uint64_t fenceValue) { waitedFenceValue = fenceValue; });
+    CHECK(allocator == 0u);
+    CHECK(waitedFenceValue == 1);
+    CHECK(pool.GetAllocatorCount() == MaxAllocatorCount);
+
+    // With every allocator open for recording there is nothing to wait for.
+    for (uint32_t i = 1; i < MaxAllocatorCount; ++i)
+    {
+        CHECK(pool.AcquireAllocator(MaxAllocatorCount, [](uint64_t) {}).has_value());
+    }
+
+    bool caught = false;
+    try
+    {
+        (void)pool.AcquireAllocator(MaxAllocatorCount, [](uint64_t) {});
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+TEST_CASE(CommandListPoolTrimsIdleAllocators)
+{
+    TestPool pool(MaxAllocatorCount, IdleTimeout);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        (void)pool.AcquireAllocator(0, [](uint64_t) {});
+        pool.Retire(i, i, i + 1);
+    }
+    pool.CollectRetired();
+
+    // Idle time counts from when the completion is first seen, the allocator still in flight stays.
+    const auto start = std::chrono::steady_clock::time_point{} + std::chrono::hours(1);
+    CHECK(pool.TrimIdle(2, start) == 0);
+    CHECK(pool.TrimIdle(2, start + IdleTimeout) == 0);
+    CHECK(pool.TrimIdle(2, start + IdleTimeout + std::chrono::seconds(1)) == 2);
+    CHECK(pool.GetAllocatorCount() == 1);
+
+    // Lists beyond the remaining allocators are released with them.
+    CHECK(pool.AcquireCommandList().has_value());
+    CHECK(!pool.AcquireCommandList().has_value());
+}
@@ -0,0 +1,101 @@
+#include "test.hpp"
+
+#include "deferred_release_queue.hpp"
+#include "fence_timeline.hpp"
+
+#include <memory>
+
+namespace
+{
+    // Counts its own destruction, stands in for a resource.
+    struct Releasable
+    {
+        std::shared_ptr<int> releaseCount;
+
+        Releasable(std::shared_ptr<int> count) : releaseCount(std::move(count)) {}
+        Releasable(Releasable&& other) noexcept = default;
+        ~Releasable()
+        {
+            if (releaseCount)
+            {
+                ++*releaseCount;
+            }
+        }
+    };
+}
+
+TEST_CASE(DeferredReleaseQueueWaitsForTheFence)
+{
+    SimulatedFence fence;
+    DeferredReleaseQueue queue(fence);
+
+    auto releaseCount = std::make_shared<int>(0);
+    queue.Retire(1, Releasable(releaseCount));
+    queue.Retire(2, Releasable(releaseCount));
+    queue.Retire(2, [releaseCount]() { ++*releaseCount; });
+    CHECK(*releaseCount == 0);
+    CHECK(queue.GetPendingCount() == 3);
+
+    CHECK(queue.ReleaseCompleted() == 0);
+
+    fence.Signal(1);
+    CHECK(queue.ReleaseCompleted() == 1);
+    CHECK(*releaseCount == 1);
+
+    fence.Signal(5);
+    CHECK(queue.ReleaseCompleted() == 2);
+    CHECK(*releaseCount == 3);
+    CHECK(queue.GetPendingCount() == 0);
+}
+
+TEST_CASE(DeferredReleaseQueueRetiresUnsubmittedWithTheSubmission)
+{
+    SimulatedFence fence;
+    DeferredReleaseQueue queue(fence);
+
+    auto releaseCount = std::make_shared<int>(0);
+    queue.RetireOnSubmit(Releasable(releaseCount));
+    queue.RetireOnSubmit([releaseCount]() { ++*releaseCount; });
+
+    // Nothing is released before the work using it is submitted, however far the fence is.
+    fence.Signal(3);
+    CHECK(queue.ReleaseCompleted() == 0);
+    CHECK(queue.GetPendingCount() == 2);
+
+    queue.RetireUnsubmitted(4);
+    CHECK(queue.ReleaseCompleted() == 0);
+
+    fence.Signal(4);
+    CHECK(queue.ReleaseCompleted() == 2);
+    CHECK(*releaseCount == 2);
+}
+
+TEST_CASE(DeferredReleaseQueueReleasesEverythingOnDestruction)
+{
+    SimulatedFence fence;
+    auto releaseCount = std::make_shared<int>(0);
+    {
+        DeferredReleaseQueue queue(fence);
+        queue.Retire(10, Releasable(releaseCount));
+        queue.RetireOnSubmit(Releasable(releaseCount));
+    }
+    CHECK(*releaseCount == 2);
+}
+
+TEST_CASE(DeferredReleaseQueueAllowsRetiringWhileReleasing)
+{
+    SimulatedFence fence;
+    DeferredReleaseQueue queue(fence);
+
+    // Releasing one entry retires the next one, as freeing a descriptor slot of a resource would.
+    bool secondReleased = false;
+    queue.Retire(1, [&]() {
+        queue.Retire(2, [&]() { secondReleased = true; });
+    });
+
+    fence.Signal(2);
+    CHECK(queue.ReleaseCompleted() == 1);
+    CHECK(!secondReleased);
+    CHECK(queue.ReleaseCompleted() == 1);
+    CHECK(secondReleased);
+}
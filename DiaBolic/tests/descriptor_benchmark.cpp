@@ -0,0 +1,192 @@
+#include "test.hpp"
+
+#include "descriptor_allocator.hpp"
+#include "view_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // DescriptorHeap itself needs a device, these mirror how it uses the allocator.
+    constexpr uint32_t ThreadCacheSize = 32;    // DESCRIPTOR_THREAD_CACHE_SIZE
+    constexpr uint32_t DescriptorsPerThread = 16384;
+
+    uint32_t GetBenchmarkThreadCount()
+    {
+        return std::clamp(std::thread::hardware_concurrency(), 4u, 16u);
+    }
+
+    // Runs function(threadIndex) on threadCount threads that start at the same time, returns the wall time.
+    template<typename Function>
+    double RunOnThreads(uint32_t threadCount, const Function& function)
+    {
+        std::atomic<bool> start{};
+        std::vector<std::thread> threads;
+        for (uint32_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            threads.emplace_back([&, threadIndex]() {
+                while (!start)
+                {
+                    std::this_thread::yield();
+                }
+                function(threadIndex);
+            });
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
+        start = true;
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    bool AreUnique(std::vector<std::vector<DescriptorAllocation>>& threadAllocations)
+    {
+        std::vector<uint32_t> indices;
+        for (const auto& allocations : threadAllocations)
+        {
+            for (const DescriptorAllocation& allocation : allocations)
+            {
+                indices.push_back(allocation.index);
+            }
+        }
+
+        std::sort(indices.begin(), indices.end());
+        return std::adjacent_find(indices.begin(), indices.end()) == indices.end();
+    }
+
+    struct BufferViewDesc
+    {
+        uint32_t firstElement;
+        uint32_t elementCount;
+        uint32_t stride;
+    };
+}
+
+BENCHMARK(DescriptorAllocationUnderContention)
+{
+    const uint32_t threadCount = GetBenchmarkThreadCount();
+    const uint32_t descriptorCount = threadCount * DescriptorsPerThread;
+
+    // Every descriptor takes the allocator lock, as Renderer::CreateSrv used to.
+    {
+        std::mutex mutex;
+        DescriptorAllocator allocator(descriptorCount);
+        std::vector<std::vector<DescriptorAllocation>> threadAllocations(threadCount);
+
+        const double nanoseconds = RunOnThreads(threadCount, [&](uint32_t threadIndex) {
+            for (uint32_t i = 0; i < DescriptorsPerThread; ++i)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threadAllocations[threadIndex].push_back(allocator.Allocate());
+            }
+        });
+        std::printf("    global lock,   %u threads: %.1f ns per descriptor\n", threadCount, nanoseconds / descriptorCount);
+
+        CHECK(allocator.GetAllocatedCount() == descriptorCount);
+        CHECK(AreUnique(threadAllocations));
+    }
+
+    // Threads reserve a block at a time and hand out single descriptors without a lock, as DescriptorHeap does.
+    {
+        std::mutex mutex;
+        DescriptorAllocator allocator(descriptorCount + threadCount * ThreadCacheSize);
+        std::vector<std::vector<DescriptorAllocation>> threadAllocations(threadCount);
+
+        const double nanoseconds = RunOnThreads(threadCount, [&](uint32_t threadIndex) {
+            std::vector<DescriptorAllocation> cache;
+            for (uint32_t i = 0; i < DescriptorsPerThread; ++i)
+            {
+                if (cache.empty())
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    const DescriptorAllocation block = allocator.Allocate(ThreadCacheSize);
+                    for (uint32_t index = block.index + block.count; index-- > block.index;)
+                    {
+                        cache.push_back(DescriptorAllocation{ .index = index, .count = 1u, .generation = allocator.GetGeneration(index) });
+                    }
+                }
+
+                threadAllocations[threadIndex].push_back(cache.back());
+                cache.pop_back();
+            }
+
+            // What the thread didn't use goes back when it exits.
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const DescriptorAllocation& descriptor : cache)
+            {
+                allocator.Free(descriptor);
+            }
+        });
+        std::printf("    thread caches, %u threads: %.1f ns per descriptor\n", threadCount, nanoseconds / descriptorCount);
+
+        CHECK(allocator.GetAllocatedCount() == descriptorCount);
+        CHECK(AreUnique(threadAllocations));
+    }
+}
+
+BENCHMARK(ViewCacheUnderContention)
+{
+    constexpr uint32_t ResourceCount = 1024;
+    constexpr uint32_t ViewsPerThread = 65536;
+
+    const uint32_t threadCount = GetBenchmarkThreadCount();
+
+    // Every thread creates and releases views of the same resources, views other threads hold are found in the cache.
+    std::mutex allocatorMutex;
+    DescriptorAllocator allocator(threadCount * ResourceCount);
+    ViewCache viewCache;
+    std::atomic<uint32_t> createdViewCount{};
+
+    const double nanoseconds = RunOnThreads(threadCount, [&](uint32_t threadIndex) {
+        std::vector<DescriptorAllocation> views(ResourceCount);
+        for (uint32_t round = 0; round < ViewsPerThread / ResourceCount; ++round)
+        {
+            for (uint32_t i = 0; i < ResourceCount; ++i)
+            {
+                const uintptr_t resource = 0x1000 + ((i + threadIndex * 131) % ResourceCount) * 0x100;
+                const BufferViewDesc desc = { .firstElement = 0u, .elementCount = 64u, .stride = 16u };
+
+                views[i] = viewCache.Acquire(ViewType::Srv, reinterpret_cast<const void*>(resource), desc);
+                if (views[i].IsNull())
+                {
+                    DescriptorAllocation newView;
+                    {
+                        std::lock_guard<std::mutex> lock(allocatorMutex);
+                        newView = allocator.Allocate();
+                    }
+                    ++createdViewCount;
+
+                    views[i] = viewCache.Add(ViewType::Srv, reinterpret_cast<const void*>(resource), desc, newView);
+                    if (views[i].index != newView.index)
+                    {
+                        std::lock_guard<std::mutex> lock(allocatorMutex);
+                        allocator.Free(newView);
+                    }
+                }
+            }
+
+            // The last thread to release a view frees its descriptor.
+            for (const DescriptorAllocation& view : views)
+            {
+                if (viewCache.Release(view))
+                {
+                    std::lock_guard<std::mutex> lock(allocatorMutex);
+                    allocator.Free(view);
+                }
+            }
+        }
+    });
+    std::printf("    %u threads: %.1f ns per view, %u views created\n", threadCount,
+        nanoseconds / (threadCount * ViewsPerThread), createdViewCount.load());
+
+    CHECK(viewCache.GetViewCount() == 0);
+    CHECK(allocator.GetAllocatedCount() == 0);
+}
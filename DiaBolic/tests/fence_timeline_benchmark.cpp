@@ -0,0 +1,113 @@
+#include "test.hpp"
+
+#include "fence_timeline.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    // Resumes on the waiter thread after every value, the caller signals the next one once it sees the resume.
+    DetachedTask AwaitEach(FenceTimeline& timeline, uint64_t valueCount, std::atomic<uint64_t>& resumedValue)
+    {
+        for (uint64_t value = 1; value <= valueCount; ++value)
+        {
+            co_await timeline.Until(value);
+            resumedValue.store(value);
+            resumedValue.notify_one();
+        }
+    }
+}
+
+BENCHMARK(FenceTimelineCallbackDispatch)
+{
+    constexpr uint64_t CallbackCount = 100000;
+
+    // One callback per value, the fence completes a single value at a time as submissions finish.
+    // The waiter thread wakes up, runs what completed and re-arms the fence as fast as it keeps up.
+    {
+        FenceWaiter waiter;
+        auto fence = std::make_shared<SimulatedFence>();
+        FenceTimeline timeline(fence, &waiter);
+
+        std::atomic<uint64_t> completedCount{};
+        std::promise<void> allCompleted;
+        for (uint64_t value = 1; value <= CallbackCount; ++value)
+        {
+            timeline.OnCompletion(value, [&]() {
+                if (++completedCount == CallbackCount)
+                {
+                    allCompleted.set_value();
+                }
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t value = 1; value <= CallbackCount; ++value)
+        {
+            fence->Signal(value);
+        }
+        CHECK(allCompleted.get_future().wait_for(10s) == std::future_status::ready);
+        const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("    signal per value: %.1f ns per callback\n", nanoseconds / CallbackCount);
+
+        CHECK(completedCount == CallbackCount);
+    }
+
+    // The fence jumps past every value at once, the waiter collects them all in one wake up.
+    {
+        FenceWaiter waiter;
+        auto fence = std::make_shared<SimulatedFence>();
+        FenceTimeline timeline(fence, &waiter);
+
+        std::atomic<uint64_t> completedCount{};
+        std::promise<void> allCompleted;
+        for (uint64_t value = 1; value <= CallbackCount; ++value)
+        {
+            timeline.OnCompletion(value, [&]() {
+                if (++completedCount == CallbackCount)
+                {
+                    allCompleted.set_value();
+                }
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        fence->Signal(CallbackCount);
+        CHECK(allCompleted.get_future().wait_for(10s) == std::future_status::ready);
+        const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("    single signal:    %.1f ns per callback\n", nanoseconds / CallbackCount);
+
+        CHECK(completedCount == CallbackCount);
+    }
+}
+
+BENCHMARK(FenceTimelineAwaitLatency)
+{
+    constexpr uint64_t ValueCount = 20000;
+
+    FenceWaiter waiter;
+    auto fence = std::make_shared<SimulatedFence>();
+    FenceTimeline timeline(fence, &waiter);
+
+    // Round trips from signaling a value to the coroutine resuming on the waiter thread.
+    std::atomic<uint64_t> resumedValue{};
+    AwaitEach(timeline, ValueCount, resumedValue);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t value = 1; value <= ValueCount; ++value)
+    {
+        fence->Signal(value);
+        for (uint64_t resumed = resumedValue.load(); resumed < value; resumed = resumedValue.load())
+        {
+            resumedValue.wait(resumed);
+        }
+    }
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("    %.1f ns from signal to resume\n", nanoseconds / ValueCount);
+
+    CHECK(resumedValue == ValueCount);
+}
@@ -0,0 +1,148 @@
+#include "test.hpp"
+
+#include "fence_timeline.hpp"
+
+#include <atomic>
+#include <future>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    // Callbacks run on the waiter thread, tests wait for them with a timeout instead of polling.
+    bool IsSetWithin(const std::future<void>& future, std::chrono::milliseconds timeout)
+    {
+        return future.wait_for(timeout) == std::future_status::ready;
+    }
+
+    DetachedTask SetAfter(FenceTimeline& timeline, uint64_t value, std::promise<void>& resumed)
+    {
+        co_await timeline.Until(value);
+        resumed.set_value();
+    }
+}
+
+TEST_CASE(FenceTimelineRunsCompletedCallbacksImmediately)
+{
+    FenceWaiter waiter;
+    FenceTimeline timeline(std::make_shared<SimulatedFence>(5), &waiter);
+
+    bool ran = false;
+    timeline.OnCompletion(5, [&ran]() { ran = true; });
+    CHECK(ran);
+    CHECK(timeline.IsComplete(5));
+    CHECK(!timeline.IsComplete(6));
+}
+
+TEST_CASE(FenceTimelineRunsCallbacksInFenceOrder)
+{
+    FenceWaiter waiter;
+    auto fence = std::make_shared<SimulatedFence>();
+    FenceTimeline timeline(fence, &waiter);
+
+    std::mutex mutex;
+    std::vector<uint64_t> order;
+    std::promise<void> allRan;
+    for (const uint64_t value : { 3ull, 1ull, 2ull })
+    {
+        timeline.OnCompletion(value, [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+            if (order.size() == 3)
+            {
+                allRan.set_value();
+            }
+        });
+    }
+
+    fence->Signal(2);
+    CHECK(timeline.Wait(2, 1000ms));
+    CHECK(!timeline.Wait(3, 10ms));
+
+    fence->Signal(3);
+    CHECK(timeline.Wait(3, 1000ms));
+
+    // Wait() returns as soon as the fence completed, the callback for 3 might still be running.
+    CHECK(IsSetWithin(allRan.get_future(), 1000ms));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK((order == std::vector<uint64_t>{ 1, 2, 3 }));
+}
+
+TEST_CASE(FenceTimelineWaitTimesOut)
+{
+    FenceWaiter waiter;
+    auto fence = std::make_shared<SimulatedFence>();
+    FenceTimeline timeline(fence, &waiter);
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!timeline.Wait(1, 20ms));
+    CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+
+    // Signaled from another thread while Wait() blocks, or just before it.
+    std::thread signaler([&fence]() { fence->Signal(1); });
+    CHECK(timeline.Wait(1));
+    signaler.join();
+}
+
+TEST_CASE(FenceTimelineResumesAwaitingCoroutines)
+{
+    FenceWaiter waiter;
+    auto fence = std::make_shared<SimulatedFence>();
+    FenceTimeline timeline(fence, &waiter);
+
+    std::promise<void> resumed;
+    const std::future<void> resumedFuture = resumed.get_future();
+    SetAfter(timeline, 4, resumed);
+    CHECK(!IsSetWithin(resumedFuture, 0ms));
+
+    fence->Signal(3);
+    CHECK(!timeline.Wait(4, 10ms));
+    CHECK(!IsSetWithin(resumedFuture, 0ms));
+
+    fence->Signal(4);
+    CHECK(IsSetWithin(resumedFuture, 1000ms));
+}
+
+TEST_CASE(FenceTimelineServesSeveralFencesFromOneWaiter)
+{
+    FenceWaiter waiter;
+    auto firstFence = std::make_shared<SimulatedFence>();
+    auto secondFence = std::make_shared<SimulatedFence>();
+    FenceTimeline firstTimeline(firstFence, &waiter);
+    FenceTimeline secondTimeline(secondFence, &waiter);
+
+    std::atomic<int> completedCount{};
+    std::promise<void> allCompleted;
+    const auto complete = [&]() {
+        if (++completedCount == 200)
+        {
+            allCompleted.set_value();
+        }
+    };
+    for (uint64_t value = 1; value <= 100; ++value)
+    {
+        firstTimeline.OnCompletion(value, complete);
+        secondTimeline.OnCompletion(value, complete);
+    }
+
+    std::thread firstSignaler([&]() {
+        for (uint64_t value = 1; value <= 100; ++value)
+        {
+            firstFence->Signal(value);
+        }
+    });
+    std::thread secondSignaler([&]() {
+        for (uint64_t value = 1; value <= 100; ++value)
+        {
+            secondFence->Signal(value);
+        }
+    });
+    firstSignaler.join();
+    secondSignaler.join();
+
+    CHECK(firstTimeline.Wait(100, 1000ms));
+    CHECK(secondTimeline.Wait(100, 1000ms));
+    CHECK(IsSetWithin(allCompleted.get_future(), 1000ms));
+    CHECK(completedCount == 200);
+}
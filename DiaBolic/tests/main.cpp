@@ -0,0 +1,49 @@
+#include "test.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    int s_failureCount = 0;
+}
+
+std::vector<Test::Case>& Test::GetCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Test::ReportFailure(const char* expression, const char* file, int line)
+{
+    std::printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    ++s_failureCount;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    int failedCaseCount = 0;
+    for (const Test::Case& testCase : Test::GetCases())
+    {
+        if (filter && !std::strstr(testCase.name, filter))
+        {
+            continue;
+        }
+
+        std::printf("[ RUN  ] %s\n", testCase.name);
+        const int previousFailureCount = s_failureCount;
+        const auto start = std::chrono::steady_clock::now();
+
+        testCase.function();
+
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const bool passed = s_failureCount == previousFailureCount;
+        failedCaseCount += passed ? 0 : 1;
+        std::printf("[ %s ] %s (%.1f ms)\n", passed ? " OK " : "FAIL", testCase.name, milliseconds);
+    }
+
+    std::printf("%d failed\n", failedCaseCount);
+    return failedCaseCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+#include "test.hpp"
+
+#include "render_graph.hpp"
+
+namespace
+{
+    constexpr uint64_t MiB = 1024 * 1024;
+
+    void NoOp(RenderPassContext&)
+    {
+    }
+
+    bool HasBarrier(const std::vector<RenderGraph::Barrier>& barriers, RenderGraph::ResourceHandle resource,
+        ResourceState before, ResourceState after)
+    {
+        for (const RenderGraph::Barrier& barrier : barriers)
+        {
+            if (barrier.resource == resource && barrier.before == before && barrier.after == after &&
+                !barrier.isUavBarrier && !barrier.isAliasingBarrier)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A chain of post effects, every pass reads the previous target and writes its own.
+    void DeclareChain(RenderGraph& graph, uint32_t targetCount, std::vector<RenderGraph::ResourceHandle>& targets)
+    {
+        graph.Reset();
+        const auto backBuffer = graph.ImportResource("Back Buffer", nullptr, ResourceState::Present, ResourceState::Present);
+
+        targets.clear();
+        for (uint32_t i = 0; i < targetCount; ++i)
+        {
+            targets.push_back(graph.CreateTransientResource("Target " + std::to_string(i), 8 * MiB, 64 * 1024, ResourceState::RenderTarget));
+
+            const uint32_t pass = graph.AddPass("Pass " + std::to_string(i), NoOp);
+            if (i > 0)
+            {
+                graph.Read(pass, targets[i - 1], ResourceState::PixelShaderResource);
+            }
+            graph.Write(pass, targets[i], ResourceState::RenderTarget, ResourceAccess::Write);
+        }
+
+        const uint32_t present = graph.AddPass("Composite", NoOp);
+        graph.Read(present, targets.back(), ResourceState::PixelShaderResource);
+        graph.Write(present, backBuffer, ResourceState::RenderTarget, ResourceAccess::Write);
+    }
+}
+
+TEST_CASE(RenderGraphAliasesTransientTargets)
+{
+    RenderGraph graph;
+    std::vector<RenderGraph::ResourceHandle> targets;
+    DeclareChain(graph, 8, targets);
+    CHECK(graph.Compile());
+
+    CHECK(graph.GetTransientHeapSize() == 16 * MiB);
+    CHECK(graph.GetUnaliasedTransientSize() == 64 * MiB);
+    CHECK(graph.GetTransientOffset(targets[2]) == graph.GetTransientOffset(targets[0]));
+
+    // The pass that first writes target 2 takes the memory over from target 0.
+    bool hasAliasingBarrier = false;
+    for (const RenderGraph::Barrier& barrier : graph.GetCompiledPasses()[2].barriers)
+    {
+        hasAliasingBarrier |= barrier.isAliasingBarrier && barrier.resource == targets[2] && barrier.aliasedResource == targets[0];
+    }
+    CHECK(hasAliasingBarrier);
+}
+
+TEST_CASE(RenderGraphReusesTheCompiledResult)
+{
+    RenderGraph graph;
+    std::vector<RenderGraph::ResourceHandle> targets;
+    DeclareChain(graph, 4, targets);
+    CHECK(graph.Compile());
+
+    DeclareChain(graph, 4, targets);
+    CHECK(!graph.Compile());
+
+    DeclareChain(graph, 5, targets);
+    CHECK(graph.Compile());
+}
+
+TEST_CASE(RenderGraphCullsPassesNobodyNeeds)
+{
+    RenderGraph graph;
+    const auto backBuffer = graph.ImportResource("Back Buffer", nullptr, ResourceState::Present, ResourceState::Present);
+    const auto unused = graph.CreateTransientResource("Unused", 1 * MiB, 64 * 1024, ResourceState::RenderTarget);
+
+    const uint32_t unusedPass = graph.AddPass("Unused", NoOp);
+    graph.Write(unusedPass, unused, ResourceState::RenderTarget, ResourceAccess::Write);
+
+    const uint32_t sideEffectPass = graph.AddPass("Readback", NoOp, true);
+    (void)sideEffectPass;
+
+    const uint32_t drawPass = graph.AddPass("Draw", NoOp);
+    graph.Write(drawPass, backBuffer, ResourceState::RenderTarget);
+
+    CHECK(graph.Compile());
+    CHECK(graph.GetCulledPassCount() == 1);
+    CHECK(graph.GetTransientOffset(unused) == RenderGraph::InvalidOffset);
+    CHECK(graph.GetCompiledPasses().size() == 2);
+    CHECK(graph.GetCompiledPasses()[0].passIndex == sideEffectPass);
+    CHECK(graph.GetCompiledPasses()[1].passIndex == drawPass);
+}
+
+TEST_CASE(RenderGraphTransitionsImportedResources)
+{
+    RenderGraph graph;
+    const auto backBuffer = graph.ImportResource("Back Buffer", nullptr, ResourceState::Present, ResourceState::Present);
+    const auto shadowMap = graph.ImportResource("Shadow Map", nullptr, ResourceState::DepthWrite, ResourceState::DepthWrite, false);
+
+    const uint32_t shadowPass = graph.AddPass("Shadows", NoOp);
+    graph.Write(shadowPass, shadowMap, ResourceState::DepthWrite, ResourceAccess::Write);
+
+    // Both readers need different read states, one combined transition covers them.
+    const uint32_t lightingPass = graph.AddPass("Lighting", NoOp);
+    graph.Read(lightingPass, shadowMap, ResourceState::PixelShaderResource);
+    graph.Write(lightingPass, backBuffer, ResourceState::RenderTarget, ResourceAccess::Write);
+
+    const uint32_t particlePass = graph.AddPass("Particles", NoOp);
+    graph.Read(particlePass, shadowMap, ResourceState::NonPixelShaderResource);
+    graph.Write(particlePass, backBuffer, ResourceState::RenderTarget);
+
+    CHECK(graph.Compile());
+
+    const auto& passes = graph.GetCompiledPasses();
+    CHECK(passes.size() == 3);
+    CHECK(passes[0].barriers.empty());
+    CHECK(HasBarrier(passes[1].barriers, shadowMap, ResourceState::DepthWrite,
+        ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource));
+    CHECK(HasBarrier(passes[1].barriers, backBuffer, ResourceState::Present, ResourceState::RenderTarget));
+    CHECK(passes[2].barriers.empty());
+
+    CHECK(HasBarrier(graph.GetFinalBarriers(), backBuffer, ResourceState::RenderTarget, ResourceState::Present));
+    CHECK(HasBarrier(graph.GetFinalBarriers(), shadowMap,
+        ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource, ResourceState::DepthWrite));
+}
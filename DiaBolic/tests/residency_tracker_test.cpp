@@ -0,0 +1,157 @@
+#include "test.hpp"
+
+#include "residency_tracker.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint64_t MiB = 1024 * 1024;
+
+    bool Contains(const std::vector<uint32_t>& handles, uint32_t handle)
+    {
+        return std::find(handles.begin(), handles.end(), handle) != handles.end();
+    }
+}
+
+TEST_CASE(ResidencyTrackerKeepsEverythingWithinBudget)
+{
+    ResidencyTracker tracker;
+    const uint32_t a = tracker.Add(10 * MiB, 1);
+    const uint32_t b = tracker.Add(20 * MiB, 1);
+
+    const ResidencyTracker::Changes changes = tracker.Update(64 * MiB, 1);
+    CHECK(changes.evict.empty());
+    CHECK(changes.makeResident.empty());
+    CHECK(tracker.IsResident(a) && tracker.IsResident(b));
+    CHECK(tracker.GetResidentSize() == 30 * MiB);
+}
+
+TEST_CASE(ResidencyTrackerEvictsLeastRecentlyUsedFirst)
+{
+    ResidencyTracker tracker;
+    const uint32_t a = tracker.Add(10 * MiB, 1);
+    const uint32_t b = tracker.Add(10 * MiB, 1);
+    const uint32_t c = tracker.Add(10 * MiB, 1);
+
+    // a becomes the most recently used one, b is the oldest now.
+    tracker.MarkUsed(a, 2);
+
+    const ResidencyTracker::Changes changes = tracker.Update(20 * MiB, 2);
+    CHECK(changes.evict.size() == 1);
+    CHECK(Contains(changes.evict, b));
+    CHECK(!tracker.IsResident(b));
+    CHECK(tracker.IsResident(a) && tracker.IsResident(c));
+    CHECK(tracker.GetResidentSize() == 20 * MiB);
+    CHECK(tracker.GetTrackedSize() == 30 * MiB);
+}
+
+TEST_CASE(ResidencyTrackerNeverEvictsWhatTheGpuMightUse)
+{
+    ResidencyTracker tracker;
+    const uint32_t a = tracker.Add(10 * MiB, 5);
+    const uint32_t b = tracker.Add(10 * MiB, 6);
+
+    // Neither completed, so both stay even though the budget is exceeded.
+    ResidencyTracker::Changes changes = tracker.Update(5 * MiB, 4);
+    CHECK(changes.evict.empty());
+    CHECK(tracker.GetResidentSize() == 20 * MiB);
+
+    // Only a completed.
+    changes = tracker.Update(5 * MiB, 5);
+    CHECK(changes.evict.size() == 1);
+    CHECK(Contains(changes.evict, a));
+    CHECK(tracker.IsResident(b));
+}
+
+TEST_CASE(ResidencyTrackerMakesUsedObjectsResidentAgain)
+{
+    ResidencyTracker tracker;
+    const uint32_t a = tracker.Add(10 * MiB, 1);
+    const uint32_t b = tracker.Add(10 * MiB, 1);
+
+    ResidencyTracker::Changes changes = tracker.Update(10 * MiB, 1);
+    CHECK(Contains(changes.evict, a));
+
+    // Using a again brings it back, and b has to make room for it.
+    tracker.MarkUsed(a, 2);
+    CHECK(tracker.IsResident(a));
+    changes = tracker.Update(10 * MiB, 1);
+    CHECK(changes.makeResident.size() == 1 && Contains(changes.makeResident, a));
+    CHECK(Contains(changes.evict, b));
+    CHECK(tracker.GetResidentSize() == 10 * MiB);
+
+    // Marking it again before the update doesn't queue it twice.
+    tracker.MarkUsed(b, 3);
+    tracker.MarkUsed(b, 3);
+    changes = tracker.Update(64 * MiB, 3);
+    CHECK(changes.makeResident.size() == 1);
+}
+
+TEST_CASE(ResidencyTrackerRemovesObjectsInAnyState)
+{
+    ResidencyTracker tracker;
+    const uint32_t resident = tracker.Add(1 * MiB, 1);
+    const uint32_t evicted = tracker.Add(2 * MiB, 1);
+    const uint32_t pending = tracker.Add(4 * MiB, 1);
+
+    (void)tracker.Update(1 * MiB, 1);
+    CHECK(!tracker.IsResident(evicted) && !tracker.IsResident(pending));
+    tracker.MarkUsed(pending, 2);
+
+    tracker.Remove(resident);
+    tracker.Remove(evicted);
+    tracker.Remove(pending);
+    CHECK(tracker.GetResidentSize() == 0);
+    CHECK(tracker.GetTrackedSize() == 0);
+
+    const ResidencyTracker::Changes changes = tracker.Update(0, 2);
+    CHECK(changes.makeResident.empty() && changes.evict.empty());
+
+    // Handles are reused.
+    const uint32_t handle = tracker.Add(1 * MiB, 3);
+    CHECK(handle == resident || handle == evicted || handle == pending);
+}
+
+TEST_CASE(ResidencyTrackerFollowsAWorkingSetUnderASimulatedBudget)
+{
+    // 32 textures of 8 MiB, a 128 MiB budget and a working set of 12 textures that slowly moves.
+    // The GPU runs two frames behind the CPU.
+    constexpr uint32_t TextureCount = 32;
+    constexpr uint32_t WorkingSetSize = 12;
+    constexpr uint64_t Budget = 128 * MiB;
+
+    ResidencyTracker tracker;
+    std::vector<uint32_t> textures;
+    for (uint32_t i = 0; i < TextureCount; ++i)
+    {
+        textures.push_back(tracker.Add(8 * MiB, 0));
+    }
+
+    bool workingSetResident = true;
+    bool withinBudget = true;
+    uint64_t evictedCount = 0;
+    for (uint64_t frame = 1; frame <= 200; ++frame)
+    {
+        const uint32_t first = static_cast<uint32_t>(frame / 4) % TextureCount;
+        for (uint32_t i = 0; i < WorkingSetSize; ++i)
+        {
+            tracker.MarkUsed(textures[(first + i) % TextureCount], frame);
+        }
+
+        const uint64_t completedFrame = frame > 2 ? frame - 2 : 0;
+        const ResidencyTracker::Changes changes = tracker.Update(Budget, completedFrame);
+        evictedCount += changes.evict.size();
+
+        for (uint32_t i = 0; i < WorkingSetSize; ++i)
+        {
+            workingSetResident &= tracker.IsResident(textures[(first + i) % TextureCount]);
+        }
+
+        // The working set plus what the two frames in flight still use always fits.
+        withinBudget &= tracker.GetResidentSize() <= Budget;
+    }
+    CHECK(workingSetResident);
+    CHECK(withinBudget);
+    CHECK(evictedCount > 0);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Just enough of a test framework to run the platform independent parts headless.
+// TEST_CASE and BENCHMARK register a function, main() runs every registered one
+// (or the ones whose name contains the first argument).
+namespace Test
+{
+	struct Case
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	std::vector<Case>& GetCases();
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*function)()) { GetCases().push_back({ name, function }); }
+	};
+
+	void ReportFailure(const char* expression, const char* file, int line);
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const Test::Registrar name##Registrar(#name, &name); \
+	static void name()
+
+#define BENCHMARK(name) TEST_CASE(name)
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			Test::ReportFailure(#expression, __FILE__, __LINE__); \
+		} \
+	} while (false)
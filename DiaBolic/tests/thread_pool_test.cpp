@@ -0,0 +1,53 @@
+#include "test.hpp"
+
+#include "utility/thread_pool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+TEST_CASE(ThreadPoolRunsEveryTaskOnce)
+{
+    Util::ThreadPool threadPool(4);
+
+    std::vector<std::atomic<int>> runCounts(1000);
+    threadPool.Execute(static_cast<uint32_t>(runCounts.size()), [&](uint32_t taskIndex) {
+        ++runCounts[taskIndex];
+    });
+
+    bool allRanOnce = true;
+    for (const auto& runCount : runCounts)
+    {
+        allRanOnce &= runCount == 1;
+    }
+    CHECK(allRanOnce);
+}
+
+TEST_CASE(ThreadPoolRethrowsTaskExceptions)
+{
+    Util::ThreadPool threadPool(4);
+
+    std::atomic<int> finishedCount{};
+    bool caught = false;
+    try
+    {
+        threadPool.Execute(64, [&](uint32_t taskIndex) {
+            if (taskIndex % 16 == 3)
+            {
+                throw std::runtime_error("task failed");
+            }
+            ++finishedCount;
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    CHECK(caught);
+
+    // The other tasks still ran, and the pool is usable afterwards.
+    CHECK(finishedCount == 60);
+
+    std::atomic<int> secondRunCount{};
+    threadPool.Execute(8, [&](uint32_t) { ++secondRunCount; });
+    CHECK(secondRunCount == 8);
+}
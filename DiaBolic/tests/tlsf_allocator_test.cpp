@@ -0,0 +1,142 @@
+#include "test.hpp"
+
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    struct LiveRange
+    {
+        TlsfAllocator::Allocation allocation;
+        uint64_t size;
+    };
+
+    bool Overlaps(std::vector<LiveRange> ranges)
+    {
+        std::sort(ranges.begin(), ranges.end(), [](const LiveRange& a, const LiveRange& b) {
+            return a.allocation.offset < b.allocation.offset;
+        });
+
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            if (ranges[i - 1].allocation.offset + ranges[i - 1].size > ranges[i].allocation.offset)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST_CASE(TlsfAllocatorFillsTheBlockExactly)
+{
+    TlsfAllocator allocator(1024);
+
+    std::vector<TlsfAllocator::Allocation> allocations;
+    for (int i = 0; i < 4; ++i)
+    {
+        allocations.push_back(allocator.Allocate(256));
+        CHECK(!allocations.back().IsNull());
+    }
+    CHECK(allocator.Allocate(1).IsNull());
+
+    allocator.Free(allocations[1]);
+    const TlsfAllocator::Allocation reused = allocator.Allocate(256);
+    CHECK(!reused.IsNull());
+    CHECK(reused.offset == allocations[1].offset);
+}
+
+TEST_CASE(TlsfAllocatorRespectsAlignment)
+{
+    TlsfAllocator allocator(1024 * 1024);
+
+    // Push the next free offset off any nice boundary first.
+    const TlsfAllocator::Allocation small = allocator.Allocate(3);
+    CHECK(!small.IsNull());
+
+    for (const uint64_t alignment : { 16ull, 256ull, 4096ull, 65536ull })
+    {
+        const TlsfAllocator::Allocation allocation = allocator.Allocate(100, alignment);
+        CHECK(!allocation.IsNull());
+        CHECK(allocation.offset % alignment == 0);
+    }
+}
+
+TEST_CASE(TlsfAllocatorReportsFragmentation)
+{
+    TlsfAllocator allocator(1024);
+
+    std::vector<TlsfAllocator::Allocation> allocations;
+    for (int i = 0; i < 4; ++i)
+    {
+        allocations.push_back(allocator.Allocate(256));
+    }
+    allocator.Free(allocations[0]);
+    allocator.Free(allocations[2]);
+
+    const TlsfAllocator::Statistics statistics = allocator.GetStatistics();
+    CHECK(statistics.size == 1024);
+    CHECK(statistics.usedSize == 512);
+    CHECK(statistics.freeSize == 512);
+    CHECK(statistics.largestFreeRange == 256);
+    CHECK(statistics.allocationCount == 2);
+    CHECK(statistics.freeRangeCount == 2);
+    CHECK(statistics.GetFragmentation() == 0.5f);
+
+    // Freeing the one in between merges everything back into a single range.
+    allocator.Free(allocations[1]);
+    allocator.Free(allocations[3]);
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetStatistics().freeRangeCount == 1);
+    CHECK(allocator.GetStatistics().GetFragmentation() == 0.0f);
+}
+
+TEST_CASE(TlsfAllocatorNeverOverlapsUnderRandomUse)
+{
+    constexpr uint64_t BlockSize = 64ull * 1024 * 1024;
+    TlsfAllocator allocator(BlockSize);
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(1, 512 * 1024);
+    std::uniform_int_distribution<int> alignmentShift(0, 16);
+
+    std::vector<LiveRange> liveRanges;
+    bool aligned = true;
+    bool inside = true;
+    for (int step = 0; step < 20000; ++step)
+    {
+        if (!liveRanges.empty() && random() % 3 == 0)
+        {
+            const size_t index = random() % liveRanges.size();
+            allocator.Free(liveRanges[index].allocation);
+            liveRanges[index] = liveRanges.back();
+            liveRanges.pop_back();
+            continue;
+        }
+
+        const uint64_t size = sizeDistribution(random);
+        const uint64_t alignment = 1ull << alignmentShift(random);
+        const TlsfAllocator::Allocation allocation = allocator.Allocate(size, alignment);
+        if (allocation.IsNull())
+        {
+            continue;
+        }
+
+        aligned &= allocation.offset % alignment == 0;
+        inside &= allocation.offset + size <= BlockSize;
+        liveRanges.push_back({ allocation, size });
+    }
+    CHECK(aligned);
+    CHECK(inside);
+    CHECK(!Overlaps(liveRanges));
+    CHECK(allocator.GetStatistics().allocationCount == liveRanges.size());
+
+    for (const LiveRange& liveRange : liveRanges)
+    {
+        allocator.Free(liveRange.allocation);
+    }
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetStatistics().largestFreeRange == BlockSize);
+}
@@ -0,0 +1,55 @@
+#include "test.hpp"
+
+#include "tlsf_allocator.hpp"
+
+#include <chrono>
+#include <random>
+
+BENCHMARK(TlsfAllocatorChurn)
+{
+    // A 256 MiB heap block filled with buffers and textures of mixed sizes and alignments.
+    constexpr uint64_t BlockSize = 256ull * 1024 * 1024;
+    constexpr int OperationCount = 1000000;
+
+    TlsfAllocator allocator(BlockSize);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(256, 4 * 1024 * 1024);
+
+    std::vector<TlsfAllocator::Allocation> allocations;
+    allocations.reserve(4096);
+    int failedCount = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int operation = 0; operation < OperationCount; ++operation)
+    {
+        if (!allocations.empty() && (allocations.size() >= 4096 || random() % 2 == 0))
+        {
+            const size_t index = random() % allocations.size();
+            allocator.Free(allocations[index]);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+
+        const uint64_t alignment = random() % 4 == 0 ? 4ull * 1024 * 1024 : 64ull * 1024;
+        const TlsfAllocator::Allocation allocation = allocator.Allocate(sizeDistribution(random), alignment);
+        if (allocation.IsNull())
+        {
+            ++failedCount;
+            continue;
+        }
+        allocations.push_back(allocation);
+    }
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const TlsfAllocator::Statistics statistics = allocator.GetStatistics();
+    std::printf("    %.1f ns per operation, %d failed, %u live, %.0f%% used, fragmentation %.2f\n",
+        nanoseconds / OperationCount, failedCount, statistics.allocationCount,
+        100.0 * static_cast<double>(statistics.usedSize) / static_cast<double>(statistics.size), statistics.GetFragmentation());
+
+    for (const TlsfAllocator::Allocation& allocation : allocations)
+    {
+        allocator.Free(allocation);
+    }
+    CHECK(allocator.IsEmpty());
+}
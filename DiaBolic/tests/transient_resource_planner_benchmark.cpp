@@ -0,0 +1,86 @@
+#include "test.hpp"
+
+#include "render_graph.hpp"
+#include "transient_resource_planner.hpp"
+
+#include <chrono>
+#include <random>
+
+namespace
+{
+    constexpr uint64_t MiB = 1024 * 1024;
+
+    void NoOp(RenderPassContext&)
+    {
+    }
+}
+
+BENCHMARK(TransientResourcePlannerFrameGraph)
+{
+    // A frame with a few dozen targets of mixed sizes and lifetimes, planned from scratch every time.
+    constexpr int PlanCount = 2000;
+
+    std::mt19937 random(99);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(1 * MiB, 32 * MiB);
+    std::uniform_int_distribution<uint32_t> passDistribution(0, 39);
+
+    std::vector<TransientResourcePlanner::Request> requests(48);
+    for (TransientResourcePlanner::Request& request : requests)
+    {
+        const uint32_t firstPass = passDistribution(random);
+        request = { .size = sizeDistribution(random), .alignment = 64 * 1024,
+                    .firstPass = firstPass, .lastPass = (std::min)(firstPass + 1 + static_cast<uint32_t>(random() % 6), 39u) };
+    }
+
+    TransientResourcePlanner planner;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < PlanCount; ++i)
+    {
+        planner.Plan(requests);
+    }
+    const double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("    %zu resources: %.1f us per plan, %.0f MiB instead of %.0f MiB\n", requests.size(), microseconds / PlanCount,
+        static_cast<double>(planner.GetSize()) / MiB, static_cast<double>(planner.GetUnaliasedSize()) / MiB);
+    CHECK(planner.GetSize() < planner.GetUnaliasedSize());
+}
+
+BENCHMARK(RenderGraphCompileChain)
+{
+    // Eight full screen targets that are each read by the next pass, compiled every frame as if the topology changed.
+    constexpr int CompileCount = 2000;
+    constexpr uint32_t TargetCount = 8;
+
+    RenderGraph graph;
+    double microseconds = 0.0;
+    for (int i = 0; i < CompileCount; ++i)
+    {
+        graph.Reset();
+        const auto backBuffer = graph.ImportResource("Back Buffer", nullptr, ResourceState::Present, ResourceState::Present);
+
+        RenderGraph::ResourceHandle previous = RenderGraph::InvalidResource;
+        for (uint32_t target = 0; target < TargetCount; ++target)
+        {
+            // The size changes every frame, so nothing is cached.
+            const auto handle = graph.CreateTransientResource("Target " + std::to_string(target),
+                8 * MiB + (i % 2) * 64 * 1024, 64 * 1024, ResourceState::RenderTarget);
+            const uint32_t pass = graph.AddPass("Pass " + std::to_string(target), NoOp);
+            if (previous != RenderGraph::InvalidResource)
+            {
+                graph.Read(pass, previous, ResourceState::PixelShaderResource);
+            }
+            graph.Write(pass, handle, ResourceState::RenderTarget, ResourceAccess::Write);
+            previous = handle;
+        }
+        const uint32_t composite = graph.AddPass("Composite", NoOp);
+        graph.Read(composite, previous, ResourceState::PixelShaderResource);
+        graph.Write(composite, backBuffer, ResourceState::RenderTarget, ResourceAccess::Write);
+
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(graph.Compile());
+        microseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::printf("    %u targets: %.1f us per compile, %.0f MiB instead of %.0f MiB\n", TargetCount, microseconds / CompileCount,
+        static_cast<double>(graph.GetTransientHeapSize()) / MiB, static_cast<double>(graph.GetUnaliasedTransientSize()) / MiB);
+}
@@ -0,0 +1,119 @@
+#include "test.hpp"
+
+#include "transient_resource_planner.hpp"
+
+#include <random>
+
+namespace
+{
+    constexpr uint64_t MiB = 1024 * 1024;
+
+    bool LifetimesOverlap(const TransientResourcePlanner::Request& a, const TransientResourcePlanner::Request& b)
+    {
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    }
+
+    bool MemoryOverlaps(uint64_t offsetA, uint64_t sizeA, uint64_t offsetB, uint64_t sizeB)
+    {
+        return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+    }
+}
+
+TEST_CASE(TransientResourcePlannerAliasesAChainOfTargets)
+{
+    // Every pass reads the target of the pass before it and writes its own, so only two live at once.
+    std::vector<TransientResourcePlanner::Request> requests;
+    for (uint32_t pass = 0; pass < 8; ++pass)
+    {
+        requests.push_back({ .size = 8 * MiB, .alignment = 64 * 1024, .firstPass = pass, .lastPass = pass + 1 });
+    }
+
+    TransientResourcePlanner planner;
+    planner.Plan(requests);
+    CHECK(planner.GetSize() == 16 * MiB);
+    CHECK(planner.GetUnaliasedSize() == 64 * MiB);
+
+    const auto& placements = planner.GetPlacements();
+    CHECK(!placements[0].isAliased && !placements[1].isAliased);
+    for (uint32_t i = 2; i < 8; ++i)
+    {
+        CHECK(placements[i].isAliased);
+        CHECK(placements[i].offset == placements[i - 2].offset);
+
+        // From the fifth target on, several earlier targets used the memory.
+        CHECK(placements[i].aliasedResource == (i < 4 ? i - 2 : TransientResourcePlanner::NoResource));
+    }
+}
+
+TEST_CASE(TransientResourcePlannerSeparatesOverlappingLifetimes)
+{
+    const std::vector<TransientResourcePlanner::Request> requests = {
+        { .size = 3 * MiB, .alignment = 64 * 1024, .firstPass = 0, .lastPass = 4 },
+        { .size = 1 * MiB, .alignment = 4 * MiB, .firstPass = 2, .lastPass = 3 },
+        { .size = 2 * MiB, .alignment = 64 * 1024, .firstPass = 4, .lastPass = 5 },
+    };
+
+    TransientResourcePlanner planner;
+    planner.Plan(requests);
+
+    const auto& placements = planner.GetPlacements();
+    CHECK(placements[1].offset % (4 * MiB) == 0);
+    CHECK(!MemoryOverlaps(placements[0].offset, 3 * MiB, placements[1].offset, 1 * MiB));
+    CHECK(!MemoryOverlaps(placements[0].offset, 3 * MiB, placements[2].offset, 2 * MiB));
+    CHECK(planner.GetUnaliasedSize() == 6 * MiB);
+}
+
+TEST_CASE(TransientResourcePlannerPlacementsAreValid)
+{
+    std::mt19937 random(2024);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(64 * 1024, 16 * MiB);
+    std::uniform_int_distribution<uint32_t> alignmentShift(12, 22);
+    std::uniform_int_distribution<uint32_t> passDistribution(0, 31);
+
+    TransientResourcePlanner planner;
+    bool aligned = true;
+    bool inside = true;
+    bool disjoint = true;
+    bool aliasesEarlier = true;
+    for (int round = 0; round < 200; ++round)
+    {
+        std::vector<TransientResourcePlanner::Request> requests(1 + random() % 24);
+        for (TransientResourcePlanner::Request& request : requests)
+        {
+            const uint32_t a = passDistribution(random);
+            const uint32_t b = passDistribution(random);
+            request = { .size = sizeDistribution(random), .alignment = 1ull << alignmentShift(random),
+                        .firstPass = (std::min)(a, b), .lastPass = (std::max)(a, b) };
+        }
+
+        planner.Plan(requests);
+        const auto& placements = planner.GetPlacements();
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            aligned &= placements[i].offset % requests[i].alignment == 0;
+            inside &= placements[i].offset + requests[i].size <= planner.GetSize();
+
+            for (size_t j = i + 1; j < requests.size(); ++j)
+            {
+                if (LifetimesOverlap(requests[i], requests[j]))
+                {
+                    disjoint &= !MemoryOverlaps(placements[i].offset, requests[i].size, placements[j].offset, requests[j].size);
+                }
+            }
+
+            // The resource that used the memory before is done before this one starts, and did use this memory.
+            const uint32_t aliased = placements[i].aliasedResource;
+            if (aliased != TransientResourcePlanner::NoResource)
+            {
+                aliasesEarlier &= placements[i].isAliased;
+                aliasesEarlier &= requests[aliased].lastPass < requests[i].firstPass;
+                aliasesEarlier &= MemoryOverlaps(placements[i].offset, requests[i].size, placements[aliased].offset, requests[aliased].size);
+            }
+        }
+        inside &= planner.GetSize() <= planner.GetUnaliasedSize() + requests.size() * (4 * MiB);
+    }
+    CHECK(aligned);
+    CHECK(inside);
+    CHECK(disjoint);
+    CHECK(aliasesEarlier);
+}
@@ -0,0 +1,141 @@
+#include "test.hpp"
+
+#include "utility/vertex_format.hpp"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace Util;
+
+TEST_CASE(HalfRoundTripsEveryHalf)
+{
+    bool roundTrips = true;
+    for (uint32_t bits = 0; bits <= 0xFFFFu; ++bits)
+    {
+        const uint16_t half = static_cast<uint16_t>(bits);
+        const bool isNaN = (half & 0x7C00u) == 0x7C00u && (half & 0x03FFu) != 0;
+        if (isNaN)
+        {
+            roundTrips &= std::isnan(HalfToFloat(half));
+            continue;
+        }
+        roundTrips &= FloatToHalf(HalfToFloat(half)) == half;
+    }
+    CHECK(roundTrips);
+}
+
+TEST_CASE(HalfConvertsSpecialValues)
+{
+    CHECK(FloatToHalf(0.0f) == 0x0000u);
+    CHECK(FloatToHalf(-0.0f) == 0x8000u);
+    CHECK(FloatToHalf(1.0f) == 0x3C00u);
+    CHECK(FloatToHalf(-2.5f) == 0xC100u);
+    CHECK(FloatToHalf(65504.0f) == 0x7BFFu);
+    CHECK(FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001u);
+    CHECK(FloatToHalf(std::numeric_limits<float>::infinity()) == 0x7C00u);
+    CHECK(std::isnan(HalfToFloat(FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Too large for a half, and too small even for a subnormal one.
+    CHECK(FloatToHalf(1.0e6f) == 0x7C00u);
+    CHECK(FloatToHalf(std::ldexp(1.0f, -26)) == 0x0000u);
+
+    // Ties go to the even mantissa.
+    CHECK(FloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00u);
+    CHECK(FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3C02u);
+}
+
+TEST_CASE(PositionsRoundTripWithinHalfAStep)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> distribution(-50.0f, 120.0f);
+
+    std::vector<float> positions(3 * 1000);
+    for (float& position : positions)
+    {
+        position = distribution(random);
+    }
+    const VertexQuantization quantization = ComputeVertexQuantization(positions);
+
+    const float normal[3] = { 0.0f, 1.0f, 0.0f };
+    const float uv[2] = { 0.0f, 0.0f };
+
+    bool withinHalfAStep = true;
+    for (size_t vertex = 0; vertex < positions.size() / 3; ++vertex)
+    {
+        const float* position = &positions[vertex * 3];
+        float decodedPosition[3], decodedNormal[3], decodedUV[2];
+        UnpackVertex(PackVertex(position, normal, uv, quantization), quantization, decodedPosition, decodedNormal, decodedUV);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // Half a quantization step, plus float rounding of the dequantization itself.
+            const float tolerance = 0.5f * quantization.scale[axis] + 1.0e-5f * std::abs(position[axis]);
+            withinHalfAStep &= std::abs(decodedPosition[axis] - position[axis]) <= tolerance;
+        }
+    }
+    CHECK(withinHalfAStep);
+}
+
+TEST_CASE(OctahedralNormalsRoundTrip)
+{
+    std::mt19937 random(11);
+    std::normal_distribution<float> distribution;
+
+    std::vector<std::array<float, 3>> normals = {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+    };
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::array<float, 3> normal = { distribution(random), distribution(random), distribution(random) };
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (float& component : normal)
+        {
+            component /= length;
+        }
+        normals.push_back(normal);
+    }
+
+    // Two 8 bit components leave a few degrees of error at worst.
+    const float minimumCosine = std::cos(3.0f * 3.14159265f / 180.0f);
+
+    bool normalized = true;
+    bool close = true;
+    for (const auto& normal : normals)
+    {
+        float decoded[3];
+        DecodeOctahedral(EncodeOctahedral(normal.data()), decoded);
+
+        const float length = std::sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]);
+        normalized &= std::abs(length - 1.0f) < 1.0e-5f;
+        close &= normal[0] * decoded[0] + normal[1] * decoded[1] + normal[2] * decoded[2] >= minimumCosine;
+    }
+    CHECK(normalized);
+    CHECK(close);
+
+    // The axes land exactly on the grid.
+    float decoded[3];
+    DecodeOctahedral(EncodeOctahedral(normals[5].data()), decoded);
+    CHECK(decoded[2] == -1.0f);
+}
+
+TEST_CASE(PackedVerticesKeepUVsAsHalfs)
+{
+    const std::vector<float> positions = { 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f };
+    const std::vector<float> normals = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f };
+    const std::vector<float> uvs = { 0.25f, 0.75f, 0.333f, 1.0f };
+
+    VertexQuantization quantization;
+    const std::vector<PackedVertex> vertices = PackVertices(positions, normals, uvs, quantization);
+    CHECK(vertices.size() == 2);
+
+    float position[3], normal[3], uv[2];
+    UnpackVertex(vertices[1], quantization, position, normal, uv);
+    CHECK(uv[0] == HalfToFloat(FloatToHalf(0.333f)));
+    CHECK(std::abs(uv[0] - 0.333f) < 1.0e-3f);
+    CHECK(uv[1] == 1.0f);
+    CHECK(std::abs(position[2] - 3.0f) <= 0.5f * quantization.scale[2] + 1.0e-6f);
+}
@@ -0,0 +1,78 @@
+#include "test.hpp"
+
+#include "view_cache.hpp"
+
+#include <new>
+
+// Padded like the D3D12 view descriptions: a 64 bit field after a 32 bit one, and a union.
+struct PaddedViewDesc
+{
+    uint32_t dimension;
+    union
+    {
+        struct
+        {
+            uint64_t firstElement;
+            uint32_t elementCount;
+        } buffer;
+        struct
+        {
+            uint32_t mipSlice;
+        } texture;
+    };
+};
+
+void WriteViewKey(ViewKeyWriter& writer, const PaddedViewDesc& desc)
+{
+    writer.Write(desc.dimension);
+    if (desc.dimension == 0)
+    {
+        writer.Write(desc.buffer.firstElement, desc.buffer.elementCount);
+    }
+    else
+    {
+        writer.Write(desc.texture.mipSlice);
+    }
+}
+
+namespace
+{
+    // Builds the description in memory filled with garbage, as a designated initializer may leave it.
+    PaddedViewDesc* MakeTextureDesc(void* storage, uint8_t garbage, uint32_t mipSlice)
+    {
+        std::memset(storage, garbage, sizeof(PaddedViewDesc));
+        PaddedViewDesc* desc = new (storage) PaddedViewDesc;
+        desc->dimension = 1;
+        desc->texture.mipSlice = mipSlice;
+        return desc;
+    }
+}
+
+TEST_CASE(ViewCacheIgnoresPaddingAndUnusedUnionMembers)
+{
+    ViewCache viewCache;
+    const void* resource = reinterpret_cast<const void*>(0x1000);
+
+    alignas(PaddedViewDesc) uint8_t firstStorage[sizeof(PaddedViewDesc)];
+    alignas(PaddedViewDesc) uint8_t secondStorage[sizeof(PaddedViewDesc)];
+    const PaddedViewDesc* first = MakeTextureDesc(firstStorage, 0xaa, 3);
+    const PaddedViewDesc* second = MakeTextureDesc(secondStorage, 0x55, 3);
+
+    const DescriptorAllocation view = { .index = 7u, .count = 1u, .generation = 1u };
+    CHECK(viewCache.Acquire(ViewType::Srv, resource, *first).IsNull());
+    CHECK(viewCache.Add(ViewType::Srv, resource, *first, view).index == view.index);
+
+    // The same view built over different garbage is found in the cache.
+    const DescriptorAllocation cachedView = viewCache.Acquire(ViewType::Srv, resource, *second);
+    CHECK(cachedView.index == view.index);
+    CHECK(viewCache.GetViewCount() == 1);
+
+    // Fields that are written still tell views apart.
+    alignas(PaddedViewDesc) uint8_t otherStorage[sizeof(PaddedViewDesc)];
+    CHECK(viewCache.Acquire(ViewType::Srv, resource, *MakeTextureDesc(otherStorage, 0xaa, 4)).IsNull());
+    CHECK(viewCache.Acquire(ViewType::Uav, resource, *first).IsNull());
+
+    CHECK(!viewCache.Release(view));
+    CHECK(viewCache.Release(cachedView));
+    CHECK(viewCache.GetViewCount() == 0);
+}
@@ -18,11 +18,41 @@
 
 #endif
 
-ConstantBufferStruct RenderResources
+// Constants of a view, allocated once per frame from the dynamic constant buffer.
+ConstantBufferStruct ViewConstants
 {
-    float4x4 MVP;
-    uint positionBufferIndex;
-    uint normalBufferIndex;
-    uint uvBufferIndex;
+    float4x4 viewProjection;
+};
+
+// Root constants of every draw, an index into the per-draw records is all a draw needs.
+struct DrawConstants
+{
+    uint drawDataIndex;     // Structured buffer of RenderResources.
+    uint drawIndex;
+};
+
+// Root constants of the spin compute pass, it writes a model matrix per frame in flight.
+struct SpinConstants
+{
+    uint modelBufferIndex;  // RW structured buffer of float4x4.
+    uint modelIndex;
+    float angle;            // In radians.
+};
+
+// Per-draw record in a structured buffer. Structured buffers are packed tightly,
+// the C++ side has to match the stride exactly.
+struct RenderResources
+{
+    uint modelBufferIndex;  // Structured buffer of float4x4, written on the async compute queue.
+    uint modelIndex;
+    float3 positionOffset;
+    uint vertexBufferIndex;
+    float3 positionScale;
     uint textureIndex;
-};
\ No newline at end of file
+    uint samplerIndex;
+    uint viewConstantsIndex;
+};
+
+#ifdef __cplusplus
+static_assert(sizeof(RenderResources) == 48, "RenderResources has to match the shader side.");
+#endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "constant_buffers.hlsli"
+#include "vertex_format.hlsli"
 
 struct VSOutput
 {
@@ -7,26 +8,36 @@ struct VSOutput
     float4 position : SV_POSITION;
 };
 
-ConstantBuffer<RenderResources> renderResources : register(b0);
+ConstantBuffer<DrawConstants> drawConstants : register(b0);
+
+RenderResources GetRenderResources()
+{
+    StructuredBuffer<RenderResources> drawData = ResourceDescriptorHeap[drawConstants.drawDataIndex];
+    return drawData[drawConstants.drawIndex];
+}
 
 VSOutput VSmain(uint vertexID : SV_VertexID)
 {
-    StructuredBuffer<float3> positionBuffer = ResourceDescriptorHeap[renderResources.positionBufferIndex];
-    StructuredBuffer<float2> uvBuffer = ResourceDescriptorHeap[renderResources.uvBufferIndex];
-    StructuredBuffer<float3> normalBuffer = ResourceDescriptorHeap[renderResources.normalBufferIndex];
+    RenderResources renderResources = GetRenderResources();
+    StructuredBuffer<PackedVertex> vertexBuffer = ResourceDescriptorHeap[renderResources.vertexBufferIndex];
+    PackedVertex vertex = vertexBuffer[vertexID];
 
     VSOutput result;
-    result.position = mul(renderResources.MVP, float4(positionBuffer[vertexID], 1.0f));
-    result.normal = normalBuffer[vertexID]; // TODO: multiply with inverse transpose
-    result.uv = uvBuffer[vertexID];
+    float3 position = UnpackPosition(vertex, renderResources.positionOffset, renderResources.positionScale);
+    ConstantBuffer<ViewConstants> viewConstants = ResourceDescriptorHeap[renderResources.viewConstantsIndex];
+    StructuredBuffer<float4x4> models = ResourceDescriptorHeap[renderResources.modelBufferIndex];
+    float4x4 model = models[renderResources.modelIndex];
+    result.position = mul(viewConstants.viewProjection, mul(model, float4(position, 1.0f)));
+    result.normal = UnpackNormal(vertex); // TODO: multiply with inverse transpose
+    result.uv = UnpackUV(vertex);
 
     return result;
 }
 
-SamplerState defaultSampler : register(s0);
-
 float4 PSmain(VSOutput PSinput) : SV_Target0
 {
+    RenderResources renderResources = GetRenderResources();
     Texture2D<float4> albedoTexture = ResourceDescriptorHeap[renderResources.textureIndex];
-    return pow(albedoTexture.Sample(defaultSampler, PSinput.uv), 1.0 / 2.2);
+    SamplerState albedoSampler = SamplerDescriptorHeap[renderResources.samplerIndex];
+    return pow(albedoTexture.Sample(albedoSampler, PSinput.uv), 1.0 / 2.2);
 }
\ No newline at end of file
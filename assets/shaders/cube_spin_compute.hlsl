@@ -0,0 +1,25 @@
+#include "constant_buffers.hlsli"
+
+ConstantBuffer<SpinConstants> spinConstants : register(b0);
+
+// Rotates the cube around (0, 1, 1), the same matrix XMMatrixRotationAxis would build on the CPU.
+[numthreads(1, 1, 1)]
+void CSmain()
+{
+    const float3 axis = normalize(float3(0.0f, 1.0f, 1.0f));
+    float s, c;
+    sincos(spinConstants.angle, s, c);
+
+    const float3x3 skew = float3x3(
+        0.0f, -axis.z, axis.y,
+        axis.z, 0.0f, -axis.x,
+        -axis.y, axis.x, 0.0f);
+    const float3x3 rotation = c * float3x3(1, 0, 0, 0, 1, 0, 0, 0, 1) + (1.0f - c) * float3x3(axis * axis.x, axis * axis.y, axis * axis.z) + s * skew;
+
+    RWStructuredBuffer<float4x4> models = ResourceDescriptorHeap[spinConstants.modelBufferIndex];
+    models[spinConstants.modelIndex] = float4x4(
+        float4(rotation[0], 0.0f),
+        float4(rotation[1], 0.0f),
+        float4(rotation[2], 0.0f),
+        float4(0.0f, 0.0f, 0.0f, 1.0f));
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Matches Util::PackedVertex, see utility/vertex_format.hpp.
+struct PackedVertex
+{
+    uint positionXY;
+    uint positionZNormal;
+    uint uv;
+};
+
+float3 UnpackPosition(PackedVertex vertex, float3 positionOffset, float3 positionScale)
+{
+    uint3 quantized = uint3(vertex.positionXY & 0xFFFF, vertex.positionXY >> 16, vertex.positionZNormal & 0xFFFF);
+    return positionOffset + float3(quantized) * positionScale;
+}
+
+float3 UnpackNormal(PackedVertex vertex)
+{
+    // Sign extend the two 8 bit snorm values in the upper half.
+    int2 snorm = int2(int(vertex.positionZNormal << 8) >> 24, int(vertex.positionZNormal) >> 24);
+    float2 encoded = max(float2(snorm) / 127.0f, -1.0f);
+
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    return normalize(normal);
+}
+
+float2 UnpackUV(PackedVertex vertex)
+{
+    return float2(f16tof32(vertex.uv), f16tof32(vertex.uv >> 16));
+}